@@ -34,31 +34,17 @@ target_sources(RNBOApp
   PRIVATE
   src/Main.cpp
   src/MainComponent.cpp
-  src/CustomAudioEditor.cpp
-  src/CustomAudioProcessor.cpp
-  ui/DroneSynthGUI.cpp
-
-  ${RNBO_CLASS_FILE}
-
-  ${RNBO_CPP_DIR}/RNBO.cpp
+  src/HotSwapProcessor.cpp
+  src/PresetFile.cpp
+  src/BufferSizeTuner.cpp
+  src/MidiIngest.cpp
+  ${RNBO_COMMON_SOURCES}
   ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
-  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorEditor.cpp
-  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessor.cpp
   )
 
-if (EXISTS ${RNBO_BINARY_DATA_FILE})
-  target_sources(RNBOApp PRIVATE ${RNBO_BINARY_DATA_FILE})
-endif()
-
 target_include_directories(RNBOApp
   PRIVATE
-  ${RNBO_CPP_DIR}/
-  ${RNBO_CPP_DIR}/src
-  ${RNBO_CPP_DIR}/common/
-  ${RNBO_CPP_DIR}/adapters/juce/
-  ${RNBO_CPP_DIR}/src/3rdparty/
-  src
-  ui
+  ${RNBO_COMMON_INCLUDE_DIRS}
 )
 
 target_compile_definitions(RNBOApp
@@ -82,6 +68,7 @@ target_link_libraries(RNBOApp
   juce::juce_audio_formats
   juce::juce_audio_processors
   juce::juce_audio_utils
+  juce::juce_dsp
   juce::juce_data_structures
   PUBLIC
   juce::juce_recommended_config_flags
@@ -0,0 +1,95 @@
+# `RNBOBenchmark` times CustomAudioProcessor::processBlock across a sweep of block sizes and sample
+# rates, with parameters either static or moving every block. Results are printed as JSON lines or
+# CSV (ns per sample, p50/p99/max block time and realtime headroom), so they can be collected by
+# scripts and compared between re-exports of the patch. Run it with `--help` for the options.
+
+# `juce_add_console_app` adds an executable target without any of the GUI application
+# boilerplate. We provide our own `main()` in src/Benchmark.cpp.
+
+juce_add_console_app(RNBOBenchmark
+  PRODUCT_NAME "RNBO Benchmark")
+
+# the RNBO adapters currently need this
+juce_generate_juce_header(RNBOBenchmark)
+
+# RNBO_COMMON_SOURCES (see CMakeLists.txt) includes the editor sources. CustomAudioProcessor
+# references CustomAudioEditor, so they're needed even though the benchmark never creates an editor.
+
+target_sources(RNBOBenchmark
+  PRIVATE
+  src/Benchmark.cpp
+  src/OfflineRenderer.cpp
+  ${RNBO_COMMON_SOURCES}
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
+  )
+
+target_include_directories(RNBOBenchmark
+  PRIVATE
+  ${RNBO_COMMON_INCLUDE_DIRS}
+)
+
+target_compile_definitions(RNBOBenchmark
+  PRIVATE
+  JUCE_WEB_BROWSER=0
+  JUCE_USE_CURL=0
+  JUCE_APPLICATION_NAME_STRING="$<TARGET_PROPERTY:RNBOBenchmark,JUCE_PRODUCT_NAME>"
+  JUCE_APPLICATION_VERSION_STRING="$<TARGET_PROPERTY:RNBOBenchmark,JUCE_VERSION>")
+
+target_link_libraries(RNBOBenchmark
+  PRIVATE
+  juce::juce_audio_basics
+  juce::juce_audio_formats
+  juce::juce_audio_processors
+  juce::juce_audio_utils
+  juce::juce_dsp
+  juce::juce_data_structures
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_lto_flags
+  juce::juce_recommended_warning_flags)
+
+# `RNBOInstanceBenchmark` creates up to 256 plugin instances through `createPluginFilter()`, the
+# same entry point a host uses, and reports instantiation time, resident memory and processing
+# cost per added instance, both round-robin on one thread and spread over a thread pool.
+
+juce_add_console_app(RNBOInstanceBenchmark
+  PRODUCT_NAME "RNBO Instance Benchmark")
+
+# the RNBO adapters currently need this
+juce_generate_juce_header(RNBOInstanceBenchmark)
+
+target_sources(RNBOInstanceBenchmark
+  PRIVATE
+  src/InstanceBenchmark.cpp
+  src/Plugin.cpp
+  ${RNBO_COMMON_SOURCES}
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
+  )
+
+target_include_directories(RNBOInstanceBenchmark
+  PRIVATE
+  ${RNBO_COMMON_INCLUDE_DIRS}
+)
+
+# build the processor the same way the plugin does
+target_compile_definitions(RNBOInstanceBenchmark
+  PRIVATE
+  JUCE_WEB_BROWSER=0
+  JUCE_USE_CURL=0
+  RNBO_JUCE_NO_CREATE_PLUGIN_FILTER=1
+  RNBO_JUCE_PARAM_DEFAULT_NOTIFY=${RNBO_JUCE_PARAM_DEFAULT_NOTIFY}
+  JUCE_APPLICATION_NAME_STRING="$<TARGET_PROPERTY:RNBOInstanceBenchmark,JUCE_PRODUCT_NAME>"
+  JUCE_APPLICATION_VERSION_STRING="$<TARGET_PROPERTY:RNBOInstanceBenchmark,JUCE_VERSION>")
+
+target_link_libraries(RNBOInstanceBenchmark
+  PRIVATE
+  juce::juce_audio_basics
+  juce::juce_audio_formats
+  juce::juce_audio_processors
+  juce::juce_audio_utils
+  juce::juce_dsp
+  juce::juce_data_structures
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_lto_flags
+  juce::juce_recommended_warning_flags)
@@ -47,29 +47,13 @@ juce_generate_juce_header(RNBOAudioPlugin)
 # that will be built into the target. This is a standard CMake command.
 
 target_sources(RNBOAudioPlugin PRIVATE
-  "${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessor.cpp"
-  "${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorEditor.cpp"
-  "${RNBO_CPP_DIR}/RNBO.cpp"
-  ${RNBO_CLASS_FILE}
   src/Plugin.cpp
-  src/CustomAudioEditor.cpp
-  src/CustomAudioProcessor.cpp
-  ui/DroneSynthGUI.cpp
+  ${RNBO_COMMON_SOURCES}
   )
 
-if (EXISTS ${RNBO_BINARY_DATA_FILE})
-  target_sources(RNBOAudioPlugin PRIVATE ${RNBO_BINARY_DATA_FILE})
-endif()
-
 target_include_directories(RNBOAudioPlugin
   PRIVATE
-  ${RNBO_CPP_DIR}/
-  ${RNBO_CPP_DIR}/src
-  ${RNBO_CPP_DIR}/common/
-  ${RNBO_CPP_DIR}/adapters/juce/
-  ${RNBO_CPP_DIR}/src/3rdparty/
-  src
-  ui
+  ${RNBO_COMMON_INCLUDE_DIRS}
 )
 
 # `target_compile_definitions` adds some preprocessor definitions to our target. In a Projucer
@@ -103,6 +87,7 @@ target_compile_definitions(RNBOAudioPlugin
 target_link_libraries(RNBOAudioPlugin
   PRIVATE
   juce::juce_audio_utils
+  juce::juce_dsp
   PUBLIC
   juce::juce_recommended_config_flags
   juce::juce_recommended_lto_flags
@@ -0,0 +1,66 @@
+# `RNBORender` is a headless command line tool that renders the exported patch to a WAV file
+# without opening a window or an audio device. It drives CustomAudioProcessor as fast as the CPU
+# allows, which makes it useful for batch rendering and for measuring faster-than-realtime
+# throughput on build machines. With `--record`/`--check` it renders a fixed set of scenarios and
+# compares them with a stored reference, exiting non-zero when the output or its cost changed, so a
+# re-export can be gated in CI. Run it with `--help` for the list of options.
+
+# `juce_add_console_app` adds an executable target without any of the GUI application
+# boilerplate. We provide our own `main()` in src/Render.cpp.
+
+juce_add_console_app(RNBORender
+  PRODUCT_NAME "RNBO Render")
+
+# the RNBO adapters currently need this
+juce_generate_juce_header(RNBORender)
+
+# RNBO_COMMON_SOURCES (see CMakeLists.txt) includes the editor sources. CustomAudioProcessor
+# references CustomAudioEditor, so they're needed even though the renderer never creates an editor.
+
+target_sources(RNBORender
+  PRIVATE
+  src/Render.cpp
+  src/OfflineRenderer.cpp
+  src/RenderCheck.cpp
+  ${RNBO_COMMON_SOURCES}
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
+  )
+
+target_include_directories(RNBORender
+  PRIVATE
+  ${RNBO_COMMON_INCLUDE_DIRS}
+)
+
+target_compile_definitions(RNBORender
+  PRIVATE
+  JUCE_WEB_BROWSER=0
+  JUCE_USE_CURL=0
+  JUCE_APPLICATION_NAME_STRING="$<TARGET_PROPERTY:RNBORender,JUCE_PRODUCT_NAME>"
+  JUCE_APPLICATION_VERSION_STRING="$<TARGET_PROPERTY:RNBORender,JUCE_VERSION>")
+
+target_link_libraries(RNBORender
+  PRIVATE
+  juce::juce_audio_basics
+  juce::juce_audio_formats
+  juce::juce_audio_processors
+  juce::juce_audio_utils
+  juce::juce_dsp
+  juce::juce_data_structures
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_lto_flags
+  juce::juce_recommended_warning_flags)
+
+# `ctest` renders the scenarios and checks them against the reference in RNBO_RENDER_GOLDEN_DIR,
+# golden/ next to this file by default. Record it once from an export you've listened to and commit
+# it with the export (see golden/README.md). Until then the test is registered but disabled.
+set(RNBO_RENDER_GOLDEN_DIR "${CMAKE_CURRENT_SOURCE_DIR}/golden" CACHE PATH "Reference renders for the RNBORender check test")
+set(RNBO_RENDER_MAX_SLOWDOWN "0.25" CACHE STRING "Allowed slowdown for the RNBORender check test, raise it on machines other than the one that recorded")
+
+add_test(NAME RNBORender.check
+  COMMAND RNBORender --check "${RNBO_RENDER_GOLDEN_DIR}" --max-slowdown ${RNBO_RENDER_MAX_SLOWDOWN})
+
+if (NOT EXISTS "${RNBO_RENDER_GOLDEN_DIR}/baseline.json")
+  message(STATUS "No render reference in ${RNBO_RENDER_GOLDEN_DIR}, RNBORender.check is disabled until one is recorded")
+  set_tests_properties(RNBORender.check PROPERTIES DISABLED TRUE)
+endif()
@@ -0,0 +1,51 @@
+# `RNBOUnitTests` runs juce::UnitTest cases for the lock-free queues and slots, the block clock,
+# the preset format, the parameter smoother, the audio tap and the outport event bus. `ctest` runs
+# it along with the render check. The smoother's ramp tests use the exported patch's first
+# continuous parameter and are skipped if it has none.
+
+# `juce_add_console_app` adds an executable target without any of the GUI application
+# boilerplate. We provide our own `main()` in src/UnitTests.cpp.
+
+juce_add_console_app(RNBOUnitTests
+  PRODUCT_NAME "RNBO Unit Tests")
+
+# the RNBO adapters currently need this
+juce_generate_juce_header(RNBOUnitTests)
+
+# RNBO_COMMON_SOURCES (see CMakeLists.txt) brings the smoother, the event bus and the RNBO
+# export the smoother tests run against.
+
+target_sources(RNBOUnitTests
+  PRIVATE
+  src/UnitTests.cpp
+  src/PresetFile.cpp
+  ${RNBO_COMMON_SOURCES}
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
+  )
+
+target_include_directories(RNBOUnitTests
+  PRIVATE
+  ${RNBO_COMMON_INCLUDE_DIRS}
+)
+
+target_compile_definitions(RNBOUnitTests
+  PRIVATE
+  JUCE_WEB_BROWSER=0
+  JUCE_USE_CURL=0
+  JUCE_APPLICATION_NAME_STRING="$<TARGET_PROPERTY:RNBOUnitTests,JUCE_PRODUCT_NAME>"
+  JUCE_APPLICATION_VERSION_STRING="$<TARGET_PROPERTY:RNBOUnitTests,JUCE_VERSION>")
+
+target_link_libraries(RNBOUnitTests
+  PRIVATE
+  juce::juce_audio_basics
+  juce::juce_audio_formats
+  juce::juce_audio_processors
+  juce::juce_audio_utils
+  juce::juce_dsp
+  juce::juce_data_structures
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_lto_flags
+  juce::juce_recommended_warning_flags)
+
+add_test(NAME RNBOUnitTests COMMAND RNBOUnitTests)
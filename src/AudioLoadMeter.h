@@ -0,0 +1,194 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+//==============================================================================
+/*
+    Measures how long each audio block takes compared to the time the device gives
+    us to produce it. The audio thread is the only writer and never locks, allocates
+    or waits. Any other thread can take a snapshot at any time.
+
+    Load is the block duration divided by its deadline (numSamples / sampleRate).
+    Every block goes into a histogram of 2% wide load bins, and a block with a load
+    above 100% counts as an overrun. Overruns don't always mean the device dropped
+    out, since drivers buffer a little, but they are the blocks that can.
+*/
+class AudioLoadMeter
+{
+public:
+    static constexpr int numBins = 101;         // 0-2%, 2-4% ... 198-200%, and everything above
+    static constexpr double binWidth = 0.02;
+
+    struct Snapshot
+    {
+        uint64_t numBlocks = 0;
+        uint64_t numOverruns = 0;
+        double   sampleRate = 0.0;
+        int      blockSize = 0;
+        double   currentLoad = 0.0;             // smoothed over roughly the last 100 ms
+        double   worstLoad = 0.0;
+        double   worstBlockMicros = 0.0;
+        std::array<uint32_t, numBins> histogram {};
+
+        // Upper edge of the bin holding the given fraction of all blocks
+        double getLoadPercentile(double fraction) const
+        {
+            if (numBlocks == 0)
+                return 0.0;
+
+            const uint64_t target = (uint64_t) std::ceil(fraction * (double) numBlocks);
+            uint64_t count = 0;
+
+            for (int i = 0; i < numBins; i++) {
+                count += histogram[(size_t) i];
+                if (count >= target)
+                    return juce::jmin((double) (i + 1) * binWidth, worstLoad);
+            }
+
+            return worstLoad;
+        }
+
+        // Column names matching toCsvRow()
+        static juce::String getCsvHeader()
+        {
+            return "blocks,overruns,sample_rate,block_size,load,load_p50,load_p99,worst_load,worst_block_us";
+        }
+
+        juce::String toCsvRow() const
+        {
+            return juce::String((juce::int64) numBlocks) + "," + juce::String((juce::int64) numOverruns) + ","
+                 + juce::String(sampleRate) + "," + juce::String(blockSize) + ","
+                 + juce::String(currentLoad, 4) + "," + juce::String(getLoadPercentile(0.5), 4) + ","
+                 + juce::String(getLoadPercentile(0.99), 4) + "," + juce::String(worstLoad, 4) + ","
+                 + juce::String(worstBlockMicros, 1);
+        }
+
+        juce::var toVar() const
+        {
+            auto object = new juce::DynamicObject();
+            object->setProperty("blocks", (juce::int64) numBlocks);
+            object->setProperty("overruns", (juce::int64) numOverruns);
+            object->setProperty("sample_rate", sampleRate);
+            object->setProperty("block_size", blockSize);
+            object->setProperty("load", currentLoad);
+            object->setProperty("load_p50", getLoadPercentile(0.5));
+            object->setProperty("load_p99", getLoadPercentile(0.99));
+            object->setProperty("worst_load", worstLoad);
+            object->setProperty("worst_block_us", worstBlockMicros);
+            return juce::var(object);
+        }
+    };
+
+    //==============================================================================
+    // Times the enclosing scope as one block, construct it at the top of processBlock
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(AudioLoadMeter& meter, int numSamples, double sampleRate) noexcept
+            : _meter(meter), _numSamples(numSamples), _sampleRate(sampleRate)
+            , _start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedBlock()
+        {
+            _meter.recordBlock(_numSamples, _sampleRate, juce::Time::getHighResolutionTicks() - _start);
+        }
+
+    private:
+        AudioLoadMeter& _meter;
+        int             _numSamples;
+        double          _sampleRate;
+        juce::int64     _start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    //==============================================================================
+    // Audio thread only
+    void recordBlock(int numSamples, double sampleRate, juce::int64 elapsedTicks) noexcept
+    {
+        if (_resetRequested.exchange(false, std::memory_order_acquire))
+            clear();
+
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        const double micros = juce::Time::highResolutionTicksToSeconds(elapsedTicks) * 1.0e6;
+        const double deadlineMicros = (double) numSamples / sampleRate * 1.0e6;
+        const double load = micros / deadlineMicros;
+
+        // single writer, so plain load/store pairs are enough and cheaper than read-modify-write
+        auto& bin = _histogram[(size_t) juce::jlimit(0, numBins - 1, (int) (load / binWidth))];
+        bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (load > 1.0)
+            _numOverruns.store(_numOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (load > _worstLoad.load(std::memory_order_relaxed))
+            _worstLoad.store(load, std::memory_order_relaxed);
+
+        if (micros > _worstBlockMicros.load(std::memory_order_relaxed))
+            _worstBlockMicros.store(micros, std::memory_order_relaxed);
+
+        // one pole smoothing with a time constant of about 100 ms whatever the block size
+        const double coefficient = juce::jmin(1.0, deadlineMicros / 100000.0);
+        const double current = _currentLoad.load(std::memory_order_relaxed);
+        _currentLoad.store(current + coefficient * (load - current), std::memory_order_relaxed);
+
+        _sampleRate.store(sampleRate, std::memory_order_relaxed);
+        _blockSize.store(numSamples, std::memory_order_relaxed);
+        _numBlocks.store(_numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //==============================================================================
+    // Any thread. The fields are read one by one, so a snapshot taken while a block is being
+    // recorded can be off by that one block.
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+        snapshot.numBlocks = _numBlocks.load(std::memory_order_acquire);
+        snapshot.numOverruns = _numOverruns.load(std::memory_order_relaxed);
+        snapshot.sampleRate = _sampleRate.load(std::memory_order_relaxed);
+        snapshot.blockSize = _blockSize.load(std::memory_order_relaxed);
+        snapshot.currentLoad = _currentLoad.load(std::memory_order_relaxed);
+        snapshot.worstLoad = _worstLoad.load(std::memory_order_relaxed);
+        snapshot.worstBlockMicros = _worstBlockMicros.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < numBins; i++)
+            snapshot.histogram[(size_t) i] = _histogram[(size_t) i].load(std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+    // Any thread. The audio thread clears the counters before recording its next block.
+    void reset() noexcept   { _resetRequested.store(true, std::memory_order_release); }
+
+private:
+    void clear() noexcept
+    {
+        for (auto& bin : _histogram)
+            bin.store(0, std::memory_order_relaxed);
+
+        _numBlocks.store(0, std::memory_order_relaxed);
+        _numOverruns.store(0, std::memory_order_relaxed);
+        _currentLoad.store(0.0, std::memory_order_relaxed);
+        _worstLoad.store(0.0, std::memory_order_relaxed);
+        _worstBlockMicros.store(0.0, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint32_t>, numBins>  _histogram {};
+    std::atomic<uint64_t>                       _numBlocks { 0 };
+    std::atomic<uint64_t>                       _numOverruns { 0 };
+    std::atomic<double>                         _sampleRate { 0.0 };
+    std::atomic<int>                            _blockSize { 0 };
+    std::atomic<double>                         _currentLoad { 0.0 };
+    std::atomic<double>                         _worstLoad { 0.0 };
+    std::atomic<double>                         _worstBlockMicros { 0.0 };
+    std::atomic<bool>                           _resetRequested { false };
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <atomic>
+#include <cstdint>
+
+//==============================================================================
+/*
+    The processor's output, mixed to mono, for displays.
+
+    The audio thread writes every block into a ring and never waits for the reader.
+    It doesn't lock or allocate either. While nobody is reading, a push is a single
+    atomic load. The reader copies the most recent samples out. If the writer lapped
+    it during the copy, it gets false and tries again on its next turn, since a
+    display can always skip a frame.
+
+    The reader copies at most maxReadSamples. The check after the copy holds for
+    blocks of up to maxReadSamples, which covers any realtime device.
+
+    The ring is only allocated when the first reader comes along, so instances whose
+    editor never shows an analyser don't carry it.
+*/
+class AudioTap
+{
+public:
+    static constexpr int capacity = 32768;      // power of two
+    static constexpr int maxReadSamples = 4096;
+
+    AudioTap() = default;
+    ~AudioTap()     { delete[] _ring.load(std::memory_order_relaxed); }
+
+    // Any thread but the audio thread, since the first one allocates the ring. Counts readers,
+    // the tap only records while there is at least one.
+    void addReader()
+    {
+        if (_ring.load(std::memory_order_acquire) == nullptr) {
+            float* ring = new float[(size_t) capacity] {};
+            float* expected = nullptr;
+            if (! _ring.compare_exchange_strong(expected, ring, std::memory_order_acq_rel))
+                delete[] ring;
+        }
+
+        _numReaders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void removeReader() noexcept    { _numReaders.fetch_sub(1, std::memory_order_relaxed); }
+
+    // Audio thread, after the block is processed
+    void push(const juce::AudioBuffer<float>& buffer, int numSamples, double sampleRate) noexcept
+    {
+        const int numChannels = buffer.getNumChannels();
+        if (_numReaders.load(std::memory_order_relaxed) <= 0 || numChannels == 0 || numSamples <= 0)
+            return;
+
+        float* const ring = _ring.load(std::memory_order_acquire);
+        if (ring == nullptr)
+            return;
+
+        const float gain = 1.0f / (float) numChannels;
+        const uint64_t written = _written.load(std::memory_order_relaxed);
+
+        for (int done = 0; done < numSamples;) {
+            const int start = (int) ((written + (uint64_t) done) & (capacity - 1));
+            const int length = juce::jmin(numSamples - done, capacity - start);
+
+            juce::FloatVectorOperations::copyWithMultiply(ring + start, buffer.getReadPointer(0, done), gain, length);
+            for (int channel = 1; channel < numChannels; channel++) {
+                juce::FloatVectorOperations::addWithMultiply(ring + start, buffer.getReadPointer(channel, done), gain, length);
+            }
+
+            done += length;
+        }
+
+        _sampleRate.store(sampleRate, std::memory_order_relaxed);
+        _written.store(written + (uint64_t) numSamples, std::memory_order_release);
+    }
+
+    // Reader thread. Copies the latest numSamples into dest, false if there aren't that many
+    // yet or the writer overtook the copy.
+    bool readLatest(float* dest, int numSamples) const noexcept
+    {
+        jassert(numSamples <= maxReadSamples);
+
+        const float* const ring = _ring.load(std::memory_order_acquire);
+        const uint64_t end = _written.load(std::memory_order_acquire);
+        if (ring == nullptr || end < (uint64_t) numSamples)
+            return false;
+
+        const uint64_t begin = end - (uint64_t) numSamples;
+        for (int done = 0; done < numSamples;) {
+            const int start = (int) ((begin + (uint64_t) done) & (capacity - 1));
+            const int length = juce::jmin(numSamples - done, capacity - start);
+
+            juce::FloatVectorOperations::copy(dest + done, ring + start, length);
+            done += length;
+        }
+
+        // keeps the copy above from moving past the check below
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // neither the blocks finished since we started nor one in progress can have reached [begin, end)
+        return _written.load(std::memory_order_relaxed) - end <= (uint64_t) (capacity - 2 * maxReadSamples);
+    }
+
+    // Any thread. Samples pushed so far, so a reader can tell whether anything new arrived.
+    uint64_t getNumWritten() const noexcept { return _written.load(std::memory_order_acquire); }
+
+    double getSampleRate() const noexcept   { return _sampleRate.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<float*>     _ring { nullptr };
+    std::atomic<uint64_t>   _written { 0 };
+    std::atomic<double>     _sampleRate { 0.0 };
+    std::atomic<int>        _numReaders { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (AudioTap)
+};
@@ -0,0 +1,234 @@
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+#include "OfflineRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+//==============================================================================
+namespace
+{
+    struct BenchmarkConfig
+    {
+        double sampleRate;
+        int blockSize;
+        bool movingParameters;
+        int oversampling = 1;
+    };
+
+    struct BenchmarkResult
+    {
+        BenchmarkConfig config;
+        int numBlocks = 0;
+        double nsPerSample = 0.0;
+        double p50Micros = 0.0;
+        double p99Micros = 0.0;
+        double maxMicros = 0.0;
+        double deadlineMicros = 0.0;
+        double headroom = 0.0;  // block deadline divided by the p99 block time
+    };
+
+    double ticksToMicros(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    // move every parameter through its whole range, with a different phase per parameter
+    void moveParameters(RNBO::CoreObject& coreObject, juce::int64 block)
+    {
+        RNBO::ParameterInfo info;
+        for (RNBO::ParameterIndex i = 0; i < (RNBO::ParameterIndex) coreObject.getNumParameters(); i++) {
+            coreObject.getParameterInfo(i, &info);
+            if (! info.visible || info.type != RNBO::ParameterTypeNumber)
+                continue;
+
+            const double phase = 0.5 + 0.5 * std::sin((double) block * 0.37 + (double) i * 1.3);
+            coreObject.setParameterValue(i, info.min + (info.max - info.min) * phase);
+        }
+    }
+
+    BenchmarkResult runBenchmark(const BenchmarkConfig& config, double seconds, double warmupSeconds)
+    {
+        std::unique_ptr<CustomAudioProcessor> processor(CustomAudioProcessor::CreateDefault());
+        processor->setOversamplingFactor(config.oversampling);
+        OfflineRenderer renderer(*processor, { config.sampleRate, config.blockSize });
+        RNBO::CoreObject& coreObject = processor->getRnboObject();
+
+        const auto warmupBlocks = (juce::int64) std::ceil(warmupSeconds * config.sampleRate / config.blockSize);
+        const auto numBlocks = (int) juce::jmax(1.0, std::ceil(seconds * config.sampleRate / config.blockSize));
+
+        for (juce::int64 block = 0; block < warmupBlocks; block++) {
+            if (config.movingParameters)
+                moveParameters(coreObject, block);
+            renderer.processNextBlock();
+        }
+
+        std::vector<juce::int64> blockTicks;
+        blockTicks.reserve((size_t) numBlocks);
+
+        for (int block = 0; block < numBlocks; block++) {
+            if (config.movingParameters)
+                moveParameters(coreObject, warmupBlocks + block);
+            renderer.processNextBlock();
+            blockTicks.push_back(renderer.getLastBlockTicks());
+        }
+
+        juce::int64 totalTicks = 0;
+        for (auto ticks : blockTicks)
+            totalTicks += ticks;
+
+        std::sort(blockTicks.begin(), blockTicks.end());
+        auto percentile = [&blockTicks](double p) {
+            const auto index = (size_t) juce::jlimit(0.0, (double) blockTicks.size() - 1.0, std::ceil(p * blockTicks.size()) - 1.0);
+            return ticksToMicros(blockTicks[index]);
+        };
+
+        BenchmarkResult result;
+        result.config = config;
+        result.numBlocks = numBlocks;
+        result.nsPerSample = ticksToMicros(totalTicks) * 1000.0 / ((double) numBlocks * config.blockSize);
+        result.p50Micros = percentile(0.50);
+        result.p99Micros = percentile(0.99);
+        result.maxMicros = ticksToMicros(blockTicks.back());
+        result.deadlineMicros = config.blockSize * 1.0e6 / config.sampleRate;
+        result.headroom = result.p99Micros > 0.0 ? result.deadlineMicros / result.p99Micros : 0.0;
+        return result;
+    }
+
+    juce::String toJson(const BenchmarkResult& r)
+    {
+        auto object = new juce::DynamicObject();
+        object->setProperty("samplerate", r.config.sampleRate);
+        object->setProperty("blocksize", r.config.blockSize);
+        object->setProperty("parameters", r.config.movingParameters ? "moving" : "static");
+        object->setProperty("oversampling", r.config.oversampling);
+        object->setProperty("blocks", r.numBlocks);
+        object->setProperty("ns_per_sample", r.nsPerSample);
+        object->setProperty("p50_us", r.p50Micros);
+        object->setProperty("p99_us", r.p99Micros);
+        object->setProperty("max_us", r.maxMicros);
+        object->setProperty("deadline_us", r.deadlineMicros);
+        object->setProperty("headroom", r.headroom);
+        return juce::JSON::toString(juce::var(object), true);
+    }
+
+    juce::String csvHeader()
+    {
+        return "samplerate,blocksize,parameters,oversampling,blocks,ns_per_sample,p50_us,p99_us,max_us,deadline_us,headroom";
+    }
+
+    juce::String toCsv(const BenchmarkResult& r)
+    {
+        juce::StringArray fields;
+        fields.add(juce::String(r.config.sampleRate));
+        fields.add(juce::String(r.config.blockSize));
+        fields.add(r.config.movingParameters ? "moving" : "static");
+        fields.add(juce::String(r.config.oversampling));
+        fields.add(juce::String(r.numBlocks));
+        fields.add(juce::String(r.nsPerSample, 3));
+        fields.add(juce::String(r.p50Micros, 3));
+        fields.add(juce::String(r.p99Micros, 3));
+        fields.add(juce::String(r.maxMicros, 3));
+        fields.add(juce::String(r.deadlineMicros, 3));
+        fields.add(juce::String(r.headroom, 3));
+        return fields.joinIntoString(",");
+    }
+
+    template <typename T>
+    std::vector<T> parseList(const juce::String& text)
+    {
+        std::vector<T> values;
+        for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+            if (token.trim().isNotEmpty())
+                values.push_back((T) token.trim().getDoubleValue());
+        return values;
+    }
+
+    void printUsage()
+    {
+        std::cout
+            << "Usage: RNBOBenchmark [options]\n"
+            << "\n"
+            << "  --blocksizes <list>      comma separated block sizes (default 16,32,...,4096)\n"
+            << "  --samplerates <list>     comma separated sample rates (default 44100,48000,88200,96000,176400,192000)\n"
+            << "  --parameters <mode>      static, moving or both (default both)\n"
+            << "  --oversampling <list>    comma separated factors out of 1,2,4,8 (default 1)\n"
+            << "  --seconds <sec>          audio rendered per configuration (default 2)\n"
+            << "  --format <fmt>           json (one object per line) or csv (default json)\n"
+            << "  --output, -o <file>      write results to a file instead of stdout\n"
+            << std::endl;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")) {
+        printUsage();
+        return 0;
+    }
+
+    std::vector<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    std::vector<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+    if (args.containsOption("--blocksizes"))
+        blockSizes = parseList<int>(args.getValueForOption("--blocksizes"));
+    if (args.containsOption("--samplerates"))
+        sampleRates = parseList<double>(args.getValueForOption("--samplerates"));
+
+    const auto parameterMode = args.containsOption("--parameters") ? args.getValueForOption("--parameters") : juce::String("both");
+    std::vector<bool> parameterModes;
+    if (parameterMode != "moving")
+        parameterModes.push_back(false);
+    if (parameterMode != "static")
+        parameterModes.push_back(true);
+
+    std::vector<int> oversamplingFactors { 1 };
+    if (args.containsOption("--oversampling"))
+        oversamplingFactors = parseList<int>(args.getValueForOption("--oversampling"));
+
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+    const bool csv = args.getValueForOption("--format") == "csv";
+
+    std::unique_ptr<juce::FileOutputStream> file;
+    if (args.containsOption("--output|-o")) {
+        auto outputFile = args.getFileForOption("--output|-o");
+        outputFile.deleteFile();
+        file = outputFile.createOutputStream();
+        if (file == nullptr || ! file->openedOk()) {
+            std::cerr << "RNBOBenchmark: couldn't write to " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    auto emit = [&file](const juce::String& line) {
+        if (file != nullptr)
+            *file << line << "\n";
+        else
+            std::cout << line << std::endl;
+    };
+
+    if (csv)
+        emit(csvHeader());
+
+    for (auto sampleRate : sampleRates) {
+        for (auto blockSize : blockSizes) {
+            for (auto moving : parameterModes) {
+                for (auto oversampling : oversamplingFactors) {
+                    if (sampleRate <= 0.0 || blockSize <= 0 || oversampling <= 0)
+                        continue;
+
+                    auto result = runBenchmark({ sampleRate, blockSize, moving, oversampling }, seconds, 0.25);
+                    emit(csv ? toCsv(result) : toJson(result));
+                }
+            }
+        }
+    }
+
+    return 0;
+}
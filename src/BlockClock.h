@@ -0,0 +1,78 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <cmath>
+
+//==============================================================================
+/*
+    Maps wall-clock arrival times onto sample offsets in the block being processed.
+
+    Anything stamped with Time::getMillisecondCounterHiRes() between two audio callbacks
+    (a slider move, a MIDI note) is placed in the following block, at the same distance
+    from that block's start as it arrived after the previous one. Every event then has
+    the same latency, one block, instead of landing on a block boundary with up to a
+    block of jitter.
+
+    The callback times themselves jitter, so the block start is a prediction from the
+    sample count, pulled gently towards the measured time. The prediction resets after
+    stalls, device restarts and faster than real time rendering. Single thread, the
+    audio thread.
+*/
+class BlockClock
+{
+public:
+    // Call at the top of every block
+    void beginBlock(int numSamples, double sampleRate) noexcept
+    {
+        const double now = juce::Time::getMillisecondCounterHiRes();
+
+        _measuredStartMs = now;
+        _numSamples = numSamples;
+        _sampleRate = sampleRate;
+        _blockMs = sampleRate > 0.0 ? numSamples * 1000.0 / sampleRate : 0.0;
+
+        const double predicted = _blockStartMs + _previousBlockMs;
+        const double error = now - predicted;
+
+        if (_previousBlockMs <= 0.0 || std::abs(error) > juce::jmax(2.0 * _blockMs, 5.0))
+            _blockStartMs = now;
+        else
+            _blockStartMs = predicted + 0.05 * error;
+
+        _previousBlockMs = _blockMs;
+    }
+
+    // Sample offset in the current block for something that arrived at arrivalMs.
+    // Anything older than one block goes at the start and sets late.
+    int getSampleOffset(double arrivalMs, bool& late) const noexcept
+    {
+        const double offset = (arrivalMs - (_blockStartMs - _blockMs)) * _sampleRate / 1000.0;
+
+        late = offset < 0.0;
+        return juce::jlimit(0, juce::jmax(0, _numSamples - 1), (int) offset);
+    }
+
+    // When the sample at offset is due, on the same clock as the arrival times
+    double getSampleTimeMs(int offset) const noexcept
+    {
+        return _blockStartMs + (_sampleRate > 0.0 ? offset * 1000.0 / _sampleRate : 0.0);
+    }
+
+    // The same, from when this callback actually started rather than the smoothed prediction.
+    // Use this to measure timing; measuring against the prediction would hide its own jitter.
+    double getMeasuredSampleTimeMs(int offset) const noexcept
+    {
+        return _measuredStartMs + (_sampleRate > 0.0 ? offset * 1000.0 / _sampleRate : 0.0);
+    }
+
+    double getSampleRate() const noexcept   { return _sampleRate; }
+
+private:
+    double  _blockStartMs = 0.0;
+    double  _measuredStartMs = 0.0;
+    double  _blockMs = 0.0;
+    double  _previousBlockMs = 0.0;
+    double  _sampleRate = 0.0;
+    int     _numSamples = 0;
+};
@@ -0,0 +1,142 @@
+#include "BufferSizeTuner.h"
+
+BufferSizeTuner::BufferSizeTuner(juce::AudioDeviceManager& deviceManager, MeterSource getMeter)
+    : _deviceManager(deviceManager)
+    , _getMeter(std::move(getMeter))
+{
+}
+
+BufferSizeTuner::~BufferSizeTuner()
+{
+    stopTimer();
+}
+
+bool BufferSizeTuner::start()
+{
+    auto* device = _deviceManager.getCurrentAudioDevice();
+    if (device == nullptr || isRunning())
+        return false;
+
+    // the current size first, so we know it holds up, then everything smaller
+    const int current = device->getCurrentBufferSizeSamples();
+    juce::Array<int> sizes = device->getAvailableBufferSizes();
+    sizes.sort();
+
+    _candidates.clearQuick();
+    _candidates.add(current);
+    for (int i = sizes.size(); --i >= 0;) {
+        if (sizes[i] < current)
+            _candidates.add(sizes[i]);
+    }
+
+    if (_candidates.size() < 2)
+        return false;
+
+    _candidate = 0;
+    _lastPassed = 0;
+    beginTrial();
+    return true;
+}
+
+void BufferSizeTuner::cancel()
+{
+    if (! isRunning())
+        return;
+
+    stopTimer();
+    _stage = Stage::idle;
+    applyBufferSize(_candidates[0]);
+}
+
+void BufferSizeTuner::beginTrial()
+{
+    const int bufferSize = _candidates[_candidate];
+
+    // a size the device won't take counts as a failure
+    if (! applyBufferSize(bufferSize)) {
+        finish(_lastPassed != 0 ? _lastPassed : _candidates[0]);
+        return;
+    }
+
+    // the first blocks after a device restart aren't representative
+    _stage = Stage::settling;
+    startTimer(settleMilliseconds);
+
+    if (onTrialStarted != nullptr)
+        onTrialStarted(bufferSize);
+}
+
+void BufferSizeTuner::timerCallback()
+{
+    if (_stage == Stage::settling) {
+        if (auto* meter = _getMeter())
+            meter->reset();
+
+        _xrunsAtStart = getXRunCount();
+        _stage = Stage::measuring;
+        startTimer(trialMilliseconds);
+        return;
+    }
+
+    stopTimer();
+
+    if (! didTrialPass()) {
+        finish(_lastPassed != 0 ? _lastPassed : _candidates[0]);
+        return;
+    }
+
+    _lastPassed = _candidates[_candidate];
+
+    if (++_candidate < _candidates.size())
+        beginTrial();
+    else
+        finish(_lastPassed);
+}
+
+bool BufferSizeTuner::didTrialPass() const
+{
+    auto* meter = _getMeter();
+    if (meter == nullptr)
+        return false;
+
+    // no blocks means the device stopped calling us, which is no pass either
+    const AudioLoadMeter::Snapshot snapshot = meter->getSnapshot();
+    if (snapshot.numBlocks == 0 || snapshot.numOverruns > 0 || snapshot.getLoadPercentile(0.99) > maxLoad)
+        return false;
+
+    // the whole callback, including what the player and the device manager do around us
+    if (_deviceManager.getCpuUsage() > maxLoad)
+        return false;
+
+    // -1 when the driver can't tell
+    const int xruns = getXRunCount();
+    return xruns < 0 || _xrunsAtStart < 0 || xruns == _xrunsAtStart;
+}
+
+void BufferSizeTuner::finish(int bufferSize)
+{
+    stopTimer();
+    _stage = Stage::idle;
+    applyBufferSize(bufferSize);
+
+    if (onFinished != nullptr)
+        onFinished(bufferSize);
+}
+
+bool BufferSizeTuner::applyBufferSize(int bufferSize)
+{
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    _deviceManager.getAudioDeviceSetup(setup);
+
+    if (setup.bufferSize == bufferSize)
+        return true;
+
+    setup.bufferSize = bufferSize;
+    return _deviceManager.setAudioDeviceSetup(setup, true).isEmpty();
+}
+
+int BufferSizeTuner::getXRunCount() const
+{
+    auto* device = _deviceManager.getCurrentAudioDevice();
+    return device != nullptr ? device->getXRunCount() : -1;
+}
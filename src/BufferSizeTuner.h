@@ -0,0 +1,68 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "AudioLoadMeter.h"
+
+#include <functional>
+
+//==============================================================================
+/*
+    Finds the smallest buffer size the current audio device can run the processor at
+    without glitching.
+
+    Starting from the current size, each smaller size the device offers gets a short
+    trial. A size passes if the device reports no xruns (where it can count them), no
+    block runs past its deadline, and the 99th percentile load stays under maxLoad. That
+    ceiling is the safety margin, leaving headroom for whatever the trial didn't
+    exercise. The first size to fail ends the search, and the smallest passing size is
+    applied and handed to onFinished.
+
+    For the trial to mean anything, the processor should be making the sound you intend
+    to play while it runs. Message thread only.
+*/
+class BufferSizeTuner : private juce::Timer
+{
+public:
+    static constexpr double maxLoad = 0.7;          // p99 load a size may reach and still pass
+    static constexpr int settleMilliseconds = 500;  // after switching size, not measured
+    static constexpr int trialMilliseconds = 3000;
+
+    using MeterSource = std::function<AudioLoadMeter*()>;
+
+    BufferSizeTuner(juce::AudioDeviceManager& deviceManager, MeterSource getMeter);
+    ~BufferSizeTuner() override;
+
+    // Returns false if there's no open device or nothing smaller to try
+    bool start();
+    void cancel();
+    bool isRunning() const { return _stage != Stage::idle; }
+
+    // The size on trial while running
+    int getTrialBufferSize() const { return _candidates[_candidate]; }
+
+    // Called with the chosen size, or with the original size if even that one failed
+    std::function<void(int bufferSize)> onFinished;
+    // Called whenever a new size goes on trial
+    std::function<void(int bufferSize)> onTrialStarted;
+
+private:
+    enum class Stage { idle, settling, measuring };
+
+    void timerCallback() override;
+    void beginTrial();
+    bool didTrialPass() const;
+    void finish(int bufferSize);
+    bool applyBufferSize(int bufferSize);
+    int getXRunCount() const;
+
+    juce::AudioDeviceManager&   _deviceManager;
+    MeterSource                 _getMeter;
+
+    juce::Array<int>            _candidates;    // largest first, starting with the size we had
+    int                         _candidate = 0;
+    int                         _lastPassed = 0;
+    int                         _xrunsAtStart = 0;
+    Stage                       _stage = Stage::idle;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferSizeTuner)
+};
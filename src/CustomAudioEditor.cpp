@@ -1,11 +1,10 @@
 #include "CustomAudioEditor.h"
 
-CustomAudioEditor::CustomAudioEditor (RNBO::JuceAudioProcessor* const p, RNBO::CoreObject& rnboObject)
+CustomAudioEditor::CustomAudioEditor (CustomAudioProcessor* const p, RNBO::CoreObject& rnboObject)
     : AudioProcessorEditor (p)
     , _rnboObject(rnboObject)
     , _audioProcessor(p)
 {
-    _audioProcessor->AudioProcessor::addListener(this);
 
   /*  _label.setText("Hi I'm Custom Interface", NotificationType::dontSendNotification);
     _label.setBounds(0, 0, 400, 300);
@@ -13,12 +12,13 @@ CustomAudioEditor::CustomAudioEditor (RNBO::JuceAudioProcessor* const p, RNBO::C
     addAndMakeVisible(_label);
     setSize (_label.getWidth(), _label.getHeight());*/
 
+    // the GUI builds its controls when it first goes on screen, this only sizes and binds it
+    _droneSynthGUI.setAudioProcessor(p);
     addAndMakeVisible(_droneSynthGUI);
     setSize(_droneSynthGUI.getWidth(), _droneSynthGUI.getHeight());
 
-    _droneSynthGUI.setAudioProcessor(p); // <--- add this line
-    addAndMakeVisible(_droneSynthGUI);
-    setSize(_droneSynthGUI.getWidth(), _droneSynthGUI.getHeight());
+    // listen only once the GUI has sized its feedback slots for this processor
+    _audioProcessor->AudioProcessor::addListener(this);
 }
 
 CustomAudioEditor::~CustomAudioEditor()
@@ -28,10 +28,12 @@ CustomAudioEditor::~CustomAudioEditor()
 
 void CustomAudioEditor::paint (Graphics& g)
 {
+    FrameProfiler::ScopedSection section(_droneSynthGUI.getFrameProfiler(), FrameProfiler::EditorPaint);
     g.fillAll(Colours::white);
 }
 
 void CustomAudioEditor::audioProcessorParameterChanged (AudioProcessor*, int parameterIndex, float value)
 {
-    // Handle parameter changes here
+    // This can be called on the audio thread, so only hand the value over, the GUI picks it up on its next tick
+    _droneSynthGUI.parameterChangedFromProcessor(parameterIndex, value);
 }
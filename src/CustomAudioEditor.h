@@ -1,12 +1,15 @@
+#pragma once
+
 #include "JuceHeader.h"
 #include "RNBO.h"
 #include "RNBO_JuceAudioProcessor.h"
+#include "CustomAudioProcessor.h"
 #include "DroneSynthGUI.h"
 
 class CustomAudioEditor : public AudioProcessorEditor, private AudioProcessorListener
 {
 public:
-    CustomAudioEditor(RNBO::JuceAudioProcessor* const p, RNBO::CoreObject& rnboObject);
+    CustomAudioEditor(CustomAudioProcessor* const p, RNBO::CoreObject& rnboObject);
     ~CustomAudioEditor() override;
     void paint (Graphics& g) override;
 
@@ -2,27 +2,19 @@
 #include "CustomAudioEditor.h"
 #include <json/json.hpp>
 
-#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
-#include <rnbo_description.h>
-#endif
+#include <algorithm>
+#include <cmath>
 
 //create an instance of our custom plugin, optionally set description, presets and binary data (datarefs)
 CustomAudioProcessor* CustomAudioProcessor::CreateDefault() {
-	nlohmann::json patcher_desc, presets;
+	// the description, presets and embedded datarefs exist once per process and are shared by all instances
+	auto processor = new CustomAudioProcessor(PatcherDescription::getShared(), SharedBinaryData::getEmbedded());
 
-#ifdef RNBO_BINARY_DATA_STORAGE_NAME
-	extern RNBO::BinaryDataImpl::Storage RNBO_BINARY_DATA_STORAGE_NAME;
-	RNBO::BinaryDataImpl::Storage dataStorage = RNBO_BINARY_DATA_STORAGE_NAME;
-#else
-	RNBO::BinaryDataImpl::Storage dataStorage;
-#endif
-	RNBO::BinaryDataImpl data(dataStorage);
+	// datarefs from disk wait for prepareToPlay, hosts create instances to scan them or restore
+	// a session long before (if ever) they play them
+	processor->_listedDatarefsPending = true;
 
-#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
-	patcher_desc = RNBO::patcher_description;
-	presets = RNBO::patcher_presets;
-#endif
-  return new CustomAudioProcessor(patcher_desc, presets, data);
+  return processor;
 }
 
 CustomAudioProcessor::CustomAudioProcessor(
@@ -32,6 +24,430 @@ CustomAudioProcessor::CustomAudioProcessor(
     ) 
   : RNBO::JuceAudioProcessor(patcher_desc, presets, data) 
 {
+	juce::StringArray outportTags;
+	for (const auto& outport : patcher_desc.value("outports", nlohmann::json::array())) {
+		if (outport.is_object() && outport.contains("tag") && outport["tag"].is_string())
+			outportTags.addIfNotAlreadyThere(outport["tag"].get<std::string>());
+	}
+	_outportEvents.setTags(outportTags);
+
+	// not thread safe means unqueued: the handler runs on whichever thread the event happens on
+	_audioThreadEventInterface = _rnboObject.createParameterInterface(RNBO::ParameterEventInterface::NotThreadSafe, &_audioThreadEvents);
+
+	const int numParameters = (int) _rnboObject.getNumParameters();
+	_queuedParameterValues.resize(numParameters);
+	_queuedParameterArrivalMs.reset(new std::atomic<double>[(size_t) juce::jmax(1, numParameters)]);
+	for (int i = 0; i < numParameters; i++) {
+		_queuedParameterArrivalMs[(size_t) i].store(0.0, std::memory_order_relaxed);
+	}
+
+	// the adapter adds a parameter per RNBO parameter, in index order
+	_hostParameterValues.resize(numParameters);
+	for (int i = 0; i < juce::jmin(numParameters, getParameters().size()); i++) {
+		getParameters()[i]->addListener(&_hostAutomationListener);
+	}
+
+	// not an RNBO parameter, so it goes after all of those and doesn't shift their indices
+	_morphParameter = new juce::AudioParameterFloat("morph", "Morph", 0.0f, 1.0f, 0.0f);
+	addParameter(_morphParameter);
+}
+
+CustomAudioProcessor::CustomAudioProcessor(PatcherDescription::Ptr description, const RNBO::BinaryData& data)
+  : CustomAudioProcessor(description->getDescription(), description->getPresets(), data)
+{
+	_description = std::move(description);
+
+	for (int i = 0; i < _description->getNumParameters(); i++) {
+		const PatcherDescription::Parameter& parameter = _description->getParameter(i);
+		if (parameter.smoothingMs > 0.0 && parameter.index != -1) {
+			_smoothingSettings.push_back({ parameter.index, parameter.smoothingMs,
+			                               parameter.exponentialSmoothing ? ParameterSmoother::Curve::exponential
+			                                                              : ParameterSmoother::Curve::linear });
+		}
+	}
+
+	if (! _smoothingSettings.empty())
+		_smoother.setSettings(_smoothingSettings, _rnboObject);
+}
+
+CustomAudioProcessor::~CustomAudioProcessor()
+{
+	// the rings go away with this object, RNBO's outlives it
+	for (const auto& stream : _streams) {
+		_rnboObject.releaseExternalData(stream.dataRefId.toRawUTF8());
+	}
+
+	collectAppliedPresets();
+	delete _scheduledPreset.exchange(nullptr);
+}
+
+void CustomAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+	if (_listedDatarefsPending) {
+		_listedDatarefsPending = false;
+		attachListedDatarefs();
+	}
+
+	_preparedBlockSize = samplesPerBlock;
+	prepareOversampling(samplesPerBlock);
+
+	// the RNBO object runs at the oversampled rate, everything else here stays at the host's
+	RNBO::JuceAudioProcessor::prepareToPlay(sampleRate * _oversamplingFactor, samplesPerBlock * _oversamplingFactor);
+}
+
+void CustomAudioProcessor::setOversamplingFactor(int factor)
+{
+	factor = juce::jlimit(1, 8, juce::nextPowerOfTwo(factor));
+	if (factor == _oversamplingFactor)
+		return;
+
+	_oversamplingFactor = factor;
+
+	if (_preparedBlockSize > 0) {
+		// waits for a block in progress, after that processBlock outputs silence until we resume
+		suspendProcessing(true);
+		prepareToPlay(getSampleRate(), _preparedBlockSize);
+		suspendProcessing(false);
+	}
+}
+
+// appended after the RNBO state: the factor as a little endian int32, then this tag
+static const char oversamplingStateTag[4] = { 'O', 'V', 'S', 'F' };
+
+void CustomAudioProcessor::getStateInformation(MemoryBlock& destData)
+{
+	RNBO::JuceAudioProcessor::getStateInformation(destData);
+
+	const juce::int32 factor = juce::ByteOrder::swapIfBigEndian((juce::int32) _oversamplingFactor);
+	destData.append(&factor, sizeof(factor));
+	destData.append(oversamplingStateTag, sizeof(oversamplingStateTag));
+}
+
+void CustomAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+	const int trailerSize = (int) (sizeof(juce::int32) + sizeof(oversamplingStateTag));
+	const char* bytes = static_cast<const char*>(data);
+
+	if (sizeInBytes >= trailerSize && memcmp(bytes + sizeInBytes - sizeof(oversamplingStateTag), oversamplingStateTag, sizeof(oversamplingStateTag)) == 0) {
+		sizeInBytes -= trailerSize;
+		RNBO::JuceAudioProcessor::setStateInformation(data, sizeInBytes);
+		setOversamplingFactor((int) juce::ByteOrder::littleEndianInt(bytes + sizeInBytes));
+		return;
+	}
+
+	RNBO::JuceAudioProcessor::setStateInformation(data, sizeInBytes);
+	setOversamplingFactor(1);
+}
+
+void CustomAudioProcessor::prepareOversampling(int samplesPerBlock)
+{
+	if (_oversamplingFactor == 1) {
+		_oversampler.reset();
+		setLatencySamples(0);
+		return;
+	}
+
+	_numOversampledChannels = juce::jmax(1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+	_oversampler = std::make_unique<juce::dsp::Oversampling<float>>(
+		(size_t) _numOversampledChannels,
+		(size_t) juce::roundToInt(std::log2(_oversamplingFactor)),
+		juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
+		true);
+	_oversampler->initProcessing((size_t) samplesPerBlock);
+
+	_oversampledChannels.allocate((size_t) _numOversampledChannels, true);
+	_oversampledMidi.ensureSize(2048);
+
+	// linear phase, so the delay is the same at every frequency. Hosts only take whole samples, so
+	// the fraction the FIR stages leave is rounded away and the output stays up to half a sample off.
+	setLatencySamples(juce::roundToInt(_oversampler->getLatencyInSamples()));
+}
+
+void CustomAudioProcessor::attachListedDatarefs()
+{
+	for (const auto& dataref : SharedBinaryData::getMappedDatarefs()) {
+		juce::String error;
+		if (dataref.stream) {
+			if (! streamExternalData(dataref.id, dataref.file, dataref.ringSeconds, dataref.loop, dataref.positionTag, error))
+				SharedBinaryData::reportError("Couldn't stream dataref " + dataref.id + ": " + error);
+		}
+		else if (! mapExternalData(dataref.id, dataref.file, error, dataref.writable)) {
+			SharedBinaryData::reportError("Couldn't map dataref " + dataref.id + ": " + error);
+		}
+	}
+}
+
+void CustomAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+	// covers everything we do per block, including draining the parameter queue
+	AudioLoadMeter::ScopedBlock measureBlock(_loadMeter, buffer.getNumSamples(), getSampleRate());
+
+	// hosts check this themselves, the hot swap wrapper in the app calls us directly
+	const juce::ScopedTryLock callbackLock(getCallbackLock());
+	if (! callbackLock.isLocked() || isSuspended()) {
+		buffer.clear();
+		return;
+	}
+
+	_lastBlockMs.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+	applyScheduledPreset();
+	applyQueuedParameterChanges(buffer.getNumSamples());
+	_morpher.process(_rnboObject, _morphParameter->get(), buffer.getNumSamples(), getSampleRate());
+	_smoother.process(_rnboObject, buffer.getNumSamples(), getSampleRate());
+
+	if (_oversampler != nullptr)
+		processOversampled(buffer, midiMessages);
+	else
+		RNBO::JuceAudioProcessor::processBlock(buffer, midiMessages);
+
+	// outport messages only reach us on the message thread, which may lag or not run at all
+	// (offline rendering), so the prefetch threads follow the position parameter from here
+	for (auto& stream : _streams) {
+		if (stream.positionParameter != -1)
+			stream.dataref->setPlayPosition((juce::int64) _rnboObject.getParameterValue(stream.positionParameter));
+	}
+
+	_tap.push(buffer, buffer.getNumSamples(), getSampleRate());
+}
+
+void CustomAudioProcessor::processOversampled(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+	const int factor = _oversamplingFactor;
+	const int numChannels = juce::jmin(buffer.getNumChannels(), _numOversampledChannels);
+
+	juce::dsp::AudioBlock<float> block(buffer.getArrayOfWritePointers(), (size_t) numChannels, (size_t) buffer.getNumSamples());
+	juce::dsp::AudioBlock<float> upsampled = _oversampler->processSamplesUp(block);
+
+	for (int channel = 0; channel < numChannels; channel++) {
+		_oversampledChannels[channel] = upsampled.getChannelPointer((size_t) channel);
+	}
+
+	juce::AudioBuffer<float> oversampledBuffer(_oversampledChannels.get(), numChannels, (int) upsampled.getNumSamples());
+
+	_oversampledMidi.clear();
+	for (const auto metadata : midiMessages) {
+		_oversampledMidi.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition * factor);
+	}
+
+	RNBO::JuceAudioProcessor::processBlock(oversampledBuffer, _oversampledMidi);
+	_oversampler->processSamplesDown(block);
+
+	// whatever the patch sent out, back at the host rate
+	midiMessages.clear();
+	for (const auto metadata : _oversampledMidi) {
+		midiMessages.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition / factor);
+	}
+}
+
+bool CustomAudioProcessor::enqueueParameterChange(RNBO::ParameterIndex index, RNBO::ParameterValue value)
+{
+	if (! juce::isPositiveAndBelow(index, (RNBO::ParameterIndex) _rnboObject.getNumParameters()))
+		return false;
+
+	// the arrival time is published by the slot's release store
+	_queuedParameterArrivalMs[(size_t) index].store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+	_queuedParameterValues.set((int) index, (float) value);
+	return true;
+}
+
+bool CustomAudioProcessor::isProcessingAudio() const noexcept
+{
+	const double lastBlockMs = _lastBlockMs.load(std::memory_order_relaxed);
+	if (lastBlockMs == 0.0 || _preparedBlockSize == 0)
+		return false;
+
+	// a few blocks' worth of slack, so large buffers and scheduling jitter don't count as stopping
+	const double blockMs = 1000.0 * _preparedBlockSize * _oversamplingFactor / juce::jmax(1.0, getSampleRate());
+	return juce::Time::getMillisecondCounterHiRes() - lastBlockMs < juce::jmax(100.0, 4.0 * blockMs);
+}
+
+void CustomAudioProcessor::applyQueuedParameterChanges(int numSamples)
+{
+	_blockClock.beginBlock(numSamples, getSampleRate());
+
+	// RNBO applies timestamped events at their sample while it processes the block, so there's
+	// no need to split the block ourselves
+	const RNBO::MillisecondTime blockStart = _rnboObject.getCurrentTime();
+	const double millisecondsPerSample = 1000.0 / getSampleRate();
+
+	_queuedParameterValues.drain([this, blockStart, millisecondsPerSample](int index, float value) {
+		bool late = false;
+		const double arrivalMs = _queuedParameterArrivalMs[(size_t) index].load(std::memory_order_relaxed);
+		const int offset = _blockClock.getSampleOffset(arrivalMs, late);
+		setParameterDirectlyOrSmoothed(index, value, blockStart + offset * millisecondsPerSample);
+	});
+
+	// already set directly by the adapter, unsmoothed parameters can keep that
+	_hostParameterValues.drain([this](int index, float value) {
+		_smoother.setTarget(_rnboObject, index, value, true);
+	});
+}
+
+void CustomAudioProcessor::HostAutomationListener::parameterValueChanged(int parameterIndex, float newValue)
+{
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		return;
+
+	const RNBO::ParameterValue value = owner._rnboObject.convertFromNormalizedParameterValue(parameterIndex, newValue);
+	owner._hostParameterValues.set(parameterIndex, (float) value);
+}
+
+void CustomAudioProcessor::setParameterDirectlyOrSmoothed(RNBO::ParameterIndex index, RNBO::ParameterValue value,
+                                                         RNBO::MillisecondTime time)
+{
+	// a smoothed parameter's ramp starts with this block, its own shape matters more than the arrival sample
+	if (! _smoother.setTarget(_rnboObject, index, value))
+		_rnboObject.setParameterValue(index, value, time);
+}
+
+bool CustomAudioProcessor::setParameterSmoothing(const juce::String& id, double milliseconds, ParameterSmoother::Curve curve)
+{
+	const RNBO::ParameterIndex index = getParameterIndexForId(id);
+	if (index == -1)
+		return false;
+
+	_smoothingSettings.erase(std::remove_if(_smoothingSettings.begin(), _smoothingSettings.end(),
+	                                        [index](const ParameterSmoother::Setting& setting) { return setting.index == index; }),
+	                         _smoothingSettings.end());
+
+	if (milliseconds > 0.0)
+		_smoothingSettings.push_back({ index, milliseconds, curve });
+
+	_smoother.setSettings(_smoothingSettings, _rnboObject);
+	return true;
+}
+
+std::vector<PresetFile::Parameter> CustomAudioProcessor::captureParameters()
+{
+	std::vector<PresetFile::Parameter> parameters;
+	parameters.reserve((size_t) _rnboObject.getNumParameters());
+
+	for (RNBO::ParameterIndex i = 0; i < _rnboObject.getNumParameters(); i++) {
+		parameters.push_back({ _rnboObject.getParameterId(i), _rnboObject.getParameterValue(i) });
+	}
+
+	return parameters;
+}
+
+void CustomAudioProcessor::schedulePreset(const std::vector<PresetFile::Parameter>& parameters)
+{
+	auto preset = std::make_unique<ScheduledPreset>();
+	preset->changes.reserve(parameters.size());
+
+	// ids the patcher doesn't have are ignored
+	for (const auto& parameter : parameters) {
+		const RNBO::ParameterIndex index = getParameterIndexForId(parameter.id);
+		if (index != -1)
+			preset->changes.push_back({ index, parameter.value });
+	}
+
+	collectAppliedPresets();
+	delete _scheduledPreset.exchange(preset.release(), std::memory_order_acq_rel);
+}
+
+void CustomAudioProcessor::setMorphSnapshots(const std::vector<PresetMorpher::Snapshot>& snapshots)
+{
+	_morpher.setSnapshots(snapshots, _rnboObject, _description.get());
+}
+
+bool CustomAudioProcessor::mapExternalData(const juce::String& dataRefId, const juce::File& file, juce::String& error, bool writable)
+{
+	SharedBinaryData::Sample::Ptr sample = SharedBinaryData::getSample(file, error);
+	if (sample == nullptr)
+		return false;
+
+	_mappedDataRefIds.addIfNotAlreadyThere(dataRefId);
+	const char* id = _mappedDataRefIds[_mappedDataRefIds.indexOf(dataRefId)].toRawUTF8();
+
+	RNBO::Float32AudioBuffer type((RNBO::Index) sample->getNumChannels(), sample->getSampleRate());
+
+	if (writable) {
+		// the patch writes into it, so it gets a copy of its own that lives until RNBO releases it
+		auto copy = std::make_shared<juce::HeapBlock<char>>(sample->getSizeInBytes());
+		memcpy(copy->get(), sample->getData(), sample->getSizeInBytes());
+		_rnboObject.setExternalData(id, copy->get(), sample->getSizeInBytes(), type, [copy](RNBO::ExternalDataId, char*) {});
+		return true;
+	}
+
+	// RNBO takes a mutable pointer, but this memory is shared and possibly a read-only mapping,
+	// which is why only datarefs the patch never writes to may share it. The release callback
+	// holds a reference so the sample outlives RNBO's use of it.
+	char* data = const_cast<char*>(reinterpret_cast<const char*>(sample->getData()));
+	_rnboObject.setExternalData(id, data, sample->getSizeInBytes(), type, [sample](RNBO::ExternalDataId, char*) {});
+	return true;
+}
+
+bool CustomAudioProcessor::streamExternalData(const juce::String& dataRefId, const juce::File& file, double ringSeconds, bool loop,
+                                              const juce::String& positionTag, juce::String& error)
+{
+	std::unique_ptr<StreamingDataref> dataref = StreamingDataref::open(file, ringSeconds, loop, error);
+	if (dataref == nullptr)
+		return false;
+
+	_mappedDataRefIds.addIfNotAlreadyThere(dataRefId);
+	const juce::String& id = _mappedDataRefIds[_mappedDataRefIds.indexOf(dataRefId)];
+
+	// the ring belongs to us, RNBO only reads it
+	RNBO::Float32AudioBuffer type((RNBO::Index) dataref->getNumChannels(), dataref->getSampleRate());
+	_rnboObject.setExternalData(id.toRawUTF8(), dataref->getRingData(), dataref->getRingSizeInBytes(), type,
+	                            [](RNBO::ExternalDataId, char*) {});
+
+	_streams.push_back({ id, positionTag, getParameterIndexForId(positionTag), std::move(dataref) });
+	return true;
+}
+
+void CustomAudioProcessor::handleMessageEvent(const RNBO::MessageEvent& event)
+{
+	RNBO::JuceAudioProcessor::handleMessageEvent(event);
+
+	if (event.getType() != RNBO::MessageEvent::Number)
+		return;
+
+	const char* tag = _rnboObject.resolveTag(event.getTag());
+	if (tag == nullptr)
+		return;
+
+	for (auto& stream : _streams) {
+		if (stream.positionParameter == -1 && stream.positionTag == tag)
+			stream.dataref->setPlayPosition((juce::int64) event.getNumValue());
+	}
+}
+
+void CustomAudioProcessor::AudioThreadEvents::handleMessageEvent(const RNBO::MessageEvent& event)
+{
+	// the bus takes one producer at a time, which the audio thread is
+	if (const char* tag = owner._rnboObject.resolveTag(event.getTag()))
+		owner._outportEvents.post(event, tag);
+}
+
+RNBO::ParameterIndex CustomAudioProcessor::getParameterIndexForId(const juce::String& id)
+{
+	return PatcherDescription::findParameterIndex(_description.get(), _rnboObject, id);
+}
+
+void CustomAudioProcessor::applyScheduledPreset()
+{
+	ScheduledPreset* preset = _scheduledPreset.exchange(nullptr, std::memory_order_acq_rel);
+	if (preset == nullptr)
+		return;
+
+	for (const auto& change : preset->changes) {
+		setParameterDirectlyOrSmoothed(change.index, change.value, _rnboObject.getCurrentTime());
+	}
+
+	// freeing isn't allowed here. schedulePreset() empties this queue before publishing, and
+	// we take at most one preset per publish, so it never holds more than one.
+	const bool handedBack = _appliedPresets.push(preset);
+	jassert(handedBack);
+	ignoreUnused(handedBack);
+}
+
+void CustomAudioProcessor::collectAppliedPresets()
+{
+	ScheduledPreset* preset = nullptr;
+	while (_appliedPresets.pop(preset)) {
+		delete preset;
+	}
 }
 
 AudioProcessorEditor* CustomAudioProcessor::createEditor()
@@ -1,15 +1,213 @@
+#pragma once
+
 #include "RNBO.h"
 #include "RNBO_Utils.h"
 #include "RNBO_JuceAudioProcessor.h"
 #include "RNBO_BinaryData.h"
+#include "LockFreeQueue.h"
+#include "ParameterValueSlots.h"
+#include "OutportEventBus.h"
+#include "AudioLoadMeter.h"
+#include "AudioTap.h"
+#include "BlockClock.h"
+#include "PresetFile.h"
+#include "PresetMorpher.h"
+#include "ParameterSmoother.h"
+#include "PatcherDescription.h"
+#include "SharedBinaryData.h"
+#include "StreamingDataref.h"
 #include <json/json.hpp>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 class CustomAudioProcessor : public RNBO::JuceAudioProcessor {
 public:
     static CustomAudioProcessor* CreateDefault();
     CustomAudioProcessor(const nlohmann::json& patcher_desc, const nlohmann::json& presets, const RNBO::BinaryData& data);
+
+    // Shares the process-wide description instead of copying the JSON for every instance
+    CustomAudioProcessor(PatcherDescription::Ptr description, const RNBO::BinaryData& data);
+    ~CustomAudioProcessor() override;
     juce::AudioProcessorEditor* createEditor() override;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
+    using RNBO::JuceAudioProcessor::processBlock;
+
+    // The RNBO state with the oversampling factor appended, so sessions reopen at the same quality.
+    // State saved before the factor was stored loads at 1x.
+    void getStateInformation(MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    // Queue a parameter change from the message thread. It reaches the RNBO object in the next
+    // block as a timestamped event, at the sample matching when it was queued, so a fast gesture
+    // keeps its shape in large blocks. Changes to one parameter before that block coalesce into the
+    // latest, so nothing stale is replayed after audio stalls. Never locks or allocates; returns
+    // false if there's no such parameter.
+    bool enqueueParameterChange(RNBO::ParameterIndex index, RNBO::ParameterValue value);
+
+    // True while blocks are arriving. Queued changes only reach the RNBO object in a block, so with
+    // no device running the editor sets parameters directly instead, and saved state stays current.
+    bool isProcessingAudio() const noexcept;
+
+    // Point a dataref at a sample file shared by all instances, memory-mapped when it's a float WAV.
+    // Pass writable if the patch writes into it; this instance then gets a private copy instead.
+    // Returns false and fills error if the file can't be used.
+    bool mapExternalData(const juce::String& dataRefId, const juce::File& file, juce::String& error, bool writable = false);
+
+    // Stream a dataref from disk through a ring buffer of ringSeconds instead of loading the whole file.
+    // The patch reports its read position in a parameter named positionTag, which is read on the audio
+    // thread after every block, or failing that to the positionTag outport. Call before processing
+    // starts. Returns false and fills error if the file can't be read.
+    bool streamExternalData(const juce::String& dataRefId, const juce::File& file, double ringSeconds, bool loop,
+                            const juce::String& positionTag, juce::String& error);
+
+    // Outport messages from the patch, as the adapter delivers them on the message thread. Updates
+    // the play positions of streamed datarefs that have no position parameter.
+    void handleMessageEvent(const RNBO::MessageEvent& event) override;
+
+    // The patch's outports by tag, for the interface to subscribe to. Posted on the audio thread as
+    // the patch sends them, drained on the message thread.
+    OutportEventBus& getOutportEvents() { return _outportEvents; }
+
+    // Parameter id to index through the shared description's table, -1 if there's no such parameter
+    RNBO::ParameterIndex getParameterIndexForId(const juce::String& id);
+
+    // Current parameter values by id, for PresetFile. Message thread.
+    std::vector<PresetFile::Parameter> captureParameters();
+
+    // Hand a decoded preset to the audio thread, it's applied at the start of the next block.
+    // Never blocks; call from one non-audio thread at a time. A preset that hasn't been picked up
+    // yet is replaced by the newer one.
+    void schedulePreset(const std::vector<PresetFile::Parameter>& parameters);
+
+    // Snapshots to morph between, in order. The morph position is the "morph" parameter, added
+    // after the RNBO parameters so hosts can automate it. Message thread.
+    void setMorphSnapshots(const std::vector<PresetMorpher::Snapshot>& snapshots);
+    juce::AudioParameterFloat* getMorphParameter() const { return _morphParameter; }
+
+    // Ramp a parameter over milliseconds whenever it's changed through enqueueParameterChange() or a
+    // preset, 0 to set it directly again. Starts from the patcher's "smooth" and "curve" meta.
+    // Message thread; returns false if there's no such parameter.
+    bool setParameterSmoothing(const juce::String& id, double milliseconds, ParameterSmoother::Curve curve);
+
+    // Runs the RNBO object at 1, 2, 4 or 8 times the host rate, with polyphase half-band filters
+    // (linear phase FIR) on the way up and down, to keep waveshapers from aliasing. The filters'
+    // delay is reported as latency, rounded to whole samples: the FIR stages can leave a fraction of
+    // a sample, which delay compensation can't express, so 2x and up stay up to half a sample off.
+    // Message thread; processing is suspended while it switches.
+    void setOversamplingFactor(int factor);
+    int getOversamplingFactor() const { return _oversamplingFactor; }
+
+    // Per-block timing of processBlock against the device deadline, readable from any thread
+    const AudioLoadMeter& getLoadMeter() const { return _loadMeter; }
+    AudioLoadMeter& getLoadMeter() { return _loadMeter; }
+
+    // The output of every block, for scopes and analysers. Costs nothing while nobody reads it.
+    AudioTap& getAudioTap() { return _tap; }
+
 private:
+    struct ParameterChange
+    {
+        RNBO::ParameterIndex index;
+        RNBO::ParameterValue value;
+    };
+
+    void applyQueuedParameterChanges(int numSamples);
+    void setParameterDirectlyOrSmoothed(RNBO::ParameterIndex index, RNBO::ParameterValue value, RNBO::MillisecondTime time);
+
+    void prepareOversampling(int samplesPerBlock);
+    void processOversampled(AudioBuffer<float>& buffer, MidiBuffer& midiMessages);
+
+    // The RNBO_MAPPED_DATAREFS_FILE entries, mapped or streamed on the first prepareToPlay
+    void attachListedDatarefs();
+    bool _listedDatarefsPending = false;
+
+    // Parameter ids resolved to indices ahead of time, so applying one is just a loop
+    struct ScheduledPreset
+    {
+        std::vector<ParameterChange> changes;
+    };
+
+    void applyScheduledPreset();
+    void collectAppliedPresets();
+
+    PatcherDescription::Ptr _description;   // null when constructed from JSON directly
+    juce::StringArray _mappedDataRefIds;    // RNBO keeps the id pointers we pass it
+
+    struct Stream
+    {
+        juce::String dataRefId;
+        juce::String positionTag;
+        RNBO::ParameterIndex positionParameter;    // -1 if the patch reports through the outport
+        std::unique_ptr<StreamingDataref> dataref;
+    };
+
+    std::vector<Stream> _streams;           // set up before processing, fixed after that
+    OutportEventBus _outportEvents;
+
+    // A second event handler on the RNBO object, called directly from the audio thread as the patch
+    // sends, so outport messages reach the bus without waiting for the adapter's message thread hop
+    class AudioThreadEvents : public RNBO::EventHandler
+    {
+    public:
+        explicit AudioThreadEvents(CustomAudioProcessor& o) : owner(o) {}
+
+        void eventsAvailable() override {}
+        void handleParameterEvent(const RNBO::ParameterEvent&) override {}
+        void handleMessageEvent(const RNBO::MessageEvent& event) override;
+
+    private:
+        CustomAudioProcessor& owner;
+    };
+
+    AudioThreadEvents _audioThreadEvents { *this };
+    RNBO::ParameterEventInterfaceUniquePtr _audioThreadEventInterface;     // destroyed before the handler it calls
+
+    // latest queued value per RNBO parameter, and when it was queued
+    ParameterValueSlots _queuedParameterValues;
+    std::unique_ptr<std::atomic<double>[]> _queuedParameterArrivalMs;
+    BlockClock _blockClock;     // audio thread
+    std::atomic<double> _lastBlockMs { 0.0 };     // when the last block started, 0 before the first
+    AudioLoadMeter _loadMeter;
+    AudioTap _tap;
+
+    int _oversamplingFactor = 1;
+    int _preparedBlockSize = 0;     // host block size, 0 until prepared
+    std::unique_ptr<juce::dsp::Oversampling<float>> _oversampler;     // null at 1x
+    juce::HeapBlock<float*> _oversampledChannels;
+    int _numOversampledChannels = 0;
+    MidiBuffer _oversampledMidi;
+
+    PresetMorpher _morpher;
+
+    std::vector<ParameterSmoother::Setting> _smoothingSettings;    // message thread
+    ParameterSmoother _smoother;
+
+    // Host automation sets the RNBO object directly through the adapter's parameters. Changes that
+    // arrive off the message thread (the adapter's own echoes and the editor's come on it) are handed
+    // to the smoother in the next block, which takes over from the direct change.
+    class HostAutomationListener : public juce::AudioProcessorParameter::Listener
+    {
+    public:
+        explicit HostAutomationListener(CustomAudioProcessor& o) : owner(o) {}
+
+        void parameterValueChanged(int parameterIndex, float newValue) override;
+        void parameterGestureChanged(int, bool) override {}
+
+    private:
+        CustomAudioProcessor& owner;
+    };
+
+    HostAutomationListener _hostAutomationListener { *this };
+    ParameterValueSlots _hostParameterValues;     // latest automated value per RNBO parameter
+    juce::AudioParameterFloat* _morphParameter = nullptr;   // owned by the processor
+
+    // lock-free handoff: the scheduling thread publishes, the audio thread takes it and hands it back to be freed
+    std::atomic<ScheduledPreset*> _scheduledPreset { nullptr };
+    LockFreeQueue<ScheduledPreset*, 8> _appliedPresets;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CustomAudioProcessor)
 };
-
@@ -0,0 +1,271 @@
+#include "HotSwapProcessor.h"
+
+//==============================================================================
+// Builds, restores and prepares a replacement instance off the message and audio threads
+class HotSwapProcessor::BuildJob : public juce::ThreadPoolJob
+{
+public:
+    BuildJob(HotSwapProcessor& owner, Factory factory, std::vector<PresetFile::Parameter> parameters, int oversamplingFactor)
+        : juce::ThreadPoolJob("RNBO hot swap")
+        , _owner(owner)
+        , _factory(std::move(factory))
+        , _parameters(std::move(parameters))
+        , _oversamplingFactor(oversamplingFactor)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        std::unique_ptr<CustomAudioProcessor> processor(_factory());
+        if (processor == nullptr)
+            return jobHasFinished;
+
+        applyParameters(*processor, _parameters);
+
+        // not prepared yet, so this only records the factor for prepareInstance
+        processor->setOversamplingFactor(_oversamplingFactor);
+
+        const double sampleRate = _owner._preparedSampleRate.load();
+        if (sampleRate > 0.0)
+            _owner.prepareInstance(*processor, sampleRate, _owner._preparedBlockSize.load());
+
+        // a build the message thread hasn't collected yet is superseded by this one
+        delete _owner._built.exchange(processor.release());
+        _owner.triggerAsyncUpdate();
+        return jobHasFinished;
+    }
+
+private:
+    HotSwapProcessor&                   _owner;
+    Factory                             _factory;
+    std::vector<PresetFile::Parameter>  _parameters;
+    int                                 _oversamplingFactor;
+};
+
+//==============================================================================
+static juce::AudioProcessor::BusesProperties getBusesFor(juce::AudioProcessor& processor)
+{
+    juce::AudioProcessor::BusesProperties buses;
+    const int numInputs = processor.getTotalNumInputChannels();
+    const int numOutputs = processor.getTotalNumOutputChannels();
+
+    if (numInputs > 0)
+        buses = buses.withInput("Input", juce::AudioChannelSet::canonicalChannelSet(numInputs), true);
+    if (numOutputs > 0)
+        buses = buses.withOutput("Output", juce::AudioChannelSet::canonicalChannelSet(numOutputs), true);
+
+    return buses;
+}
+
+HotSwapProcessor::HotSwapProcessor(std::unique_ptr<CustomAudioProcessor> initial)
+    : juce::AudioProcessor(getBusesFor(*initial))
+{
+    _current = initial.get();
+    _messageThreadProcessor = initial.get();
+    _instances.add(initial.release());
+}
+
+HotSwapProcessor::~HotSwapProcessor()
+{
+    // the player must have let go of us already, so the audio thread is gone
+    _buildThread.removeAllJobs(true, 10000);
+    cancelPendingUpdate();
+    stopTimer();
+
+    delete _built.exchange(nullptr);
+}
+
+const juce::String HotSwapProcessor::getName() const
+{
+    return _messageThreadProcessor != nullptr ? _messageThreadProcessor->getName() : juce::String();
+}
+
+double HotSwapProcessor::getTailLengthSeconds() const
+{
+    return _messageThreadProcessor != nullptr ? _messageThreadProcessor->getTailLengthSeconds() : 0.0;
+}
+
+//==============================================================================
+void HotSwapProcessor::swapAsync(Factory factory)
+{
+    std::vector<PresetFile::Parameter> parameters;
+    int oversamplingFactor = 1;
+    if (_messageThreadProcessor != nullptr) {
+        parameters = _messageThreadProcessor->captureParameters();
+        oversamplingFactor = _messageThreadProcessor->getOversamplingFactor();
+    }
+
+    _buildThread.addJob(new BuildJob(*this, std::move(factory), std::move(parameters), oversamplingFactor), true);
+}
+
+void HotSwapProcessor::applyParameters(CustomAudioProcessor& processor, const std::vector<PresetFile::Parameter>& parameters)
+{
+    RNBO::CoreObject& coreObject = processor.getRnboObject();
+
+    // matched by id, parameters the new patcher no longer has are dropped
+    for (const auto& parameter : parameters) {
+        const RNBO::ParameterIndex index = processor.getParameterIndexForId(parameter.id);
+        if (index != -1)
+            coreObject.setParameterValue(index, parameter.value);
+    }
+}
+
+void HotSwapProcessor::prepareInstance(CustomAudioProcessor& processor, double sampleRate, int blockSize)
+{
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+}
+
+void HotSwapProcessor::handleAsyncUpdate()
+{
+    CustomAudioProcessor* next = _built.exchange(nullptr);
+    if (next == nullptr)
+        return;
+
+    _instances.add(next);
+
+    // the device may have been reconfigured while we were building
+    const double sampleRate = _preparedSampleRate.load();
+    if (sampleRate > 0.0 && (next->getSampleRate() != sampleRate || next->getBlockSize() != _preparedBlockSize.load()))
+        prepareInstance(*next, sampleRate, _preparedBlockSize.load());
+
+    _messageThreadProcessor = next;
+    if (onProcessorChanged)
+        onProcessorChanged(next);
+
+    // an instance the audio thread never picked up can go straight away, nothing references it now
+    if (CustomAudioProcessor* skipped = _pending.exchange(next, std::memory_order_acq_rel))
+        deleteInstance(skipped);
+
+    startTimerHz(10);
+}
+
+void HotSwapProcessor::timerCallback()
+{
+    CustomAudioProcessor* retired = nullptr;
+    while (_retired.pop(retired)) {
+        deleteInstance(retired);
+    }
+
+    if (_instances.size() <= 1)
+        stopTimer();
+}
+
+void HotSwapProcessor::deleteInstance(CustomAudioProcessor* processor)
+{
+    jassert(processor != _messageThreadProcessor);
+
+    processor->releaseResources();
+    _instances.removeObject(processor);
+}
+
+//==============================================================================
+void HotSwapProcessor::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    // audio is stopped, so a waiting instance can take over without a fade
+    if (CustomAudioProcessor* next = _pending.exchange(nullptr, std::memory_order_acq_rel)) {
+        if (_current != nullptr)
+            _retired.push(_current);
+        _current = next;
+    }
+
+    if (_fadingOut != nullptr) {
+        _retired.push(_fadingOut);
+        _fadingOut = nullptr;
+    }
+
+    if (_current != nullptr)
+        prepareInstance(*_current, sampleRate, maximumExpectedSamplesPerBlock);
+
+    _fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * _crossfadeSeconds));
+    _fadeBuffer.setSize(juce::jmax(1, getTotalNumInputChannels(), getTotalNumOutputChannels()), maximumExpectedSamplesPerBlock);
+    _fadeMidi.ensureSize(4096);
+
+    _preparedBlockSize.store(maximumExpectedSamplesPerBlock);
+    _preparedSampleRate.store(sampleRate);
+}
+
+void HotSwapProcessor::releaseResources()
+{
+    if (_current != nullptr)
+        _current->releaseResources();
+}
+
+void HotSwapProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    // one fade at a time, a newer instance waits in _pending until this one has finished
+    if (_fadingOut == nullptr) {
+        if (CustomAudioProcessor* next = _pending.exchange(nullptr, std::memory_order_acq_rel)) {
+            _fadingOut = _current;
+            _fadePosition = 0;
+            _current = next;
+        }
+    }
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = juce::jmin(buffer.getNumChannels(), _fadeBuffer.getNumChannels());
+
+    // both instances hear the same notes during a crossfade
+    if (_midiIngest != nullptr)
+        _midiIngest->renderNextBlock(midiMessages, numSamples, getSampleRate());
+
+    // the outgoing instance gets its own copy of the input, taken before the new one overwrites it
+    juce::AudioBuffer<float> fadeBlock;
+    const bool canFade = _fadingOut != nullptr && numSamples <= _fadeBuffer.getNumSamples();
+    if (canFade) {
+        fadeBlock.setDataToReferTo(_fadeBuffer.getArrayOfWritePointers(), _fadeBuffer.getNumChannels(), numSamples);
+        for (int channel = 0; channel < numChannels; channel++) {
+            fadeBlock.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+        }
+
+        _fadeMidi.clear();
+        _fadeMidi.addEvents(midiMessages, 0, numSamples, 0);
+    }
+
+    if (_current != nullptr)
+        _current->processBlock(buffer, midiMessages);
+    else
+        buffer.clear();
+
+    if (_fadingOut == nullptr)
+        return;
+
+    if (canFade) {
+        _fadingOut->processBlock(fadeBlock, _fadeMidi);
+
+        // linear crossfade, the new instance ramps in while the old one ramps out
+        const int length = juce::jmin(numSamples, _fadeLength - _fadePosition);
+        const float startGain = (float) _fadePosition / (float) _fadeLength;
+        const float endGain = (float) (_fadePosition + length) / (float) _fadeLength;
+
+        for (int channel = 0; channel < numChannels; channel++) {
+            buffer.applyGainRamp(channel, 0, length, startGain, endGain);
+            buffer.addFromWithRamp(channel, 0, fadeBlock.getReadPointer(channel), length, 1.0f - startGain, 1.0f - endGain);
+        }
+
+        _fadePosition += length;
+    }
+    else {
+        // a block bigger than promised, cut over rather than allocate
+        _fadePosition = _fadeLength;
+    }
+
+    // if the retire queue is full we just keep the old instance around for another block
+    if (_fadePosition >= _fadeLength && _retired.push(_fadingOut))
+        _fadingOut = nullptr;
+}
+
+//==============================================================================
+void HotSwapProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    if (_messageThreadProcessor != nullptr)
+        _messageThreadProcessor->getStateInformation(destData);
+}
+
+void HotSwapProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    if (_messageThreadProcessor != nullptr)
+        _messageThreadProcessor->setStateInformation(data, sizeInBytes);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+#include "LockFreeQueue.h"
+#include "MidiIngest.h"
+
+#include <atomic>
+#include <functional>
+
+//==============================================================================
+/*
+    Sits between the AudioProcessorPlayer and the RNBO processor so the processor can be
+    replaced while audio keeps running.
+
+    swapAsync() builds and prepares the replacement on a background thread, copying the
+    parameter values of the running instance by parameter id, and its oversampling factor.
+    The finished instance is handed to the audio thread through an atomic pointer, and the
+    audio thread crossfades from the old instance to the new one over a few milliseconds.
+    Instances are only ever created, prepared and deleted off the audio thread.
+*/
+class HotSwapProcessor : public juce::AudioProcessor, private juce::AsyncUpdater, private juce::Timer
+{
+public:
+    using Factory = std::function<CustomAudioProcessor*()>;
+
+    explicit HotSwapProcessor(std::unique_ptr<CustomAudioProcessor> initial);
+    ~HotSwapProcessor() override;
+
+    // Message thread. The instance the UI should talk to, the most recently built one.
+    CustomAudioProcessor* getProcessor() const { return _messageThreadProcessor; }
+
+    // Message thread. Builds a replacement with factory on a background thread and fades
+    // over to it once it's ready. onProcessorChanged is called when getProcessor() changes.
+    void swapAsync(Factory factory);
+    std::function<void(CustomAudioProcessor*)> onProcessorChanged;
+
+    void setCrossfadeSeconds(double seconds) { _crossfadeSeconds = seconds; }
+
+    // Hardware MIDI placed by arrival time, merged into every block before the instances see
+    // it. Set it before audio starts; it must outlive this processor's use of it.
+    void setMidiIngest(MidiIngest* ingest) { _midiIngest = ingest; }
+
+    //==============================================================================
+    const juce::String getName() const override;
+    void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    using juce::AudioProcessor::processBlock;
+
+    double getTailLengthSeconds() const override;
+    bool acceptsMidi() const override   { return true; }
+    bool producesMidi() const override  { return true; }
+
+    bool hasEditor() const override                         { return false; }
+    juce::AudioProcessorEditor* createEditor() override     { return nullptr; }
+
+    int getNumPrograms() override                               { return 1; }
+    int getCurrentProgram() override                            { return 0; }
+    void setCurrentProgram(int) override                        {}
+    const juce::String getProgramName(int) override             { return {}; }
+    void changeProgramName(int, const juce::String&) override   {}
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+private:
+    class BuildJob;
+
+    static void applyParameters(CustomAudioProcessor& processor, const std::vector<PresetFile::Parameter>& parameters);
+    void prepareInstance(CustomAudioProcessor& processor, double sampleRate, int blockSize);
+
+    void handleAsyncUpdate() override;     // a background build finished
+    void timerCallback() override;          // collects instances the audio thread has faded out
+    void deleteInstance(CustomAudioProcessor* processor);
+
+    // owned here, created and destroyed on the message thread or the build thread only
+    juce::OwnedArray<CustomAudioProcessor>  _instances;
+    CustomAudioProcessor*                   _messageThreadProcessor = nullptr;
+
+    // build thread -> message thread
+    std::atomic<CustomAudioProcessor*>      _built { nullptr };
+    juce::ThreadPool                        _buildThread { 1 };
+
+    // message thread -> audio thread, and back once faded out
+    std::atomic<CustomAudioProcessor*>      _pending { nullptr };
+    LockFreeQueue<CustomAudioProcessor*, 16> _retired;
+
+    // audio thread
+    CustomAudioProcessor*                   _current = nullptr;
+    CustomAudioProcessor*                   _fadingOut = nullptr;
+    int                                     _fadePosition = 0;
+    int                                     _fadeLength = 0;
+    juce::AudioBuffer<float>                _fadeBuffer;
+    juce::MidiBuffer                        _fadeMidi;
+
+    std::atomic<double>                     _preparedSampleRate { 0.0 };
+    std::atomic<int>                        _preparedBlockSize { 0 };
+    double                                  _crossfadeSeconds = 0.01;
+    MidiIngest*                             _midiIngest = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HotSwapProcessor)
+};
@@ -0,0 +1,349 @@
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #if JUCE_MSVC
+  #pragma comment(lib, "psapi.lib")
+ #endif
+#endif
+
+// defined in Plugin.cpp, this is what a host calls for every new instance
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//==============================================================================
+namespace
+{
+    juce::int64 getResidentSetSize()
+    {
+#if JUCE_LINUX
+        juce::StringArray fields;
+        fields.addTokens(juce::File("/proc/self/statm").loadFileAsString(), " ", "");
+        return fields[1].getLargeIntValue() * (juce::int64) sysconf(_SC_PAGESIZE);
+#elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+            return 0;
+        return (juce::int64) info.resident_size;
+#elif JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+        if (! GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+        return (juce::int64) counters.WorkingSetSize;
+#else
+        return 0;
+#endif
+    }
+
+    double ticksToMicros(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    // Puts an editor in its own desktop window, as a host does. The drone interface builds its
+    // controls only once it's showing, so an editor that never goes on screen costs next to nothing.
+    // False if there's no display to show it on.
+    bool showOnDesktop(juce::AudioProcessorEditor& editor)
+    {
+        if (juce::Desktop::getInstance().getDisplays().getPrimaryDisplay() == nullptr)
+            return false;
+
+        editor.addToDesktop(0);
+        editor.setVisible(true);
+        return true;
+    }
+
+    struct Instance
+    {
+        // declared in this order so the editor is deleted before its processor
+        std::unique_ptr<juce::AudioProcessor> processor;
+        std::unique_ptr<juce::AudioProcessorEditor> editor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+
+        void process()
+        {
+            buffer.clear();
+            midi.clear();
+            processor->processBlock(buffer, midi);
+        }
+    };
+
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        int maxInstances = 256;
+        int blocksPerMeasurement = 200;
+        int numThreads = juce::jmax(1, juce::SystemStats::getNumCpus() - 1);
+        bool withEditors = false;
+        bool csv = false;
+    };
+
+    // Process every instance once per round on a pool of worker threads, the calling thread
+    // waits for all of them, like a host with a multi-threaded audio engine would.
+    class PoolProcessor
+    {
+    public:
+        explicit PoolProcessor(int numThreads)
+            : _pool(numThreads)
+            , _numThreads(numThreads)
+        {
+        }
+
+        void processRound(std::vector<std::unique_ptr<Instance>>& instances)
+        {
+            _remaining = _numThreads;
+            for (int worker = 0; worker < _numThreads; worker++) {
+                _pool.addJob([this, worker, &instances] {
+                    for (size_t i = (size_t) worker; i < instances.size(); i += (size_t) _numThreads)
+                        instances[i]->process();
+
+                    if (--_remaining == 0)
+                        _done.signal();
+                });
+            }
+            _done.wait();
+        }
+
+    private:
+        juce::ThreadPool _pool;
+        const int _numThreads;
+        std::atomic<int> _remaining { 0 };
+        juce::WaitableEvent _done;
+    };
+
+    // average time per round of processing every instance once, in microseconds
+    template <typename ProcessRound>
+    double measureRounds(int numRounds, ProcessRound&& processRound)
+    {
+        processRound(); // warm up caches after new instances were added
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int round = 0; round < numRounds; round++)
+            processRound();
+        return ticksToMicros(juce::Time::getHighResolutionTicks() - start) / numRounds;
+    }
+
+    // Times the pieces that make up a single instantiation so it's clear which one dominates.
+    void printBreakdown(const Settings& settings)
+    {
+        double descriptionMicros = 0.0, binaryDataMicros = 0.0;
+
+        {
+            // paid by the first instance only, every later one shares the result
+            const auto start = juce::Time::getHighResolutionTicks();
+            auto description = PatcherDescription::getShared();
+            descriptionMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+            juce::ignoreUnused(description);
+        }
+        {
+            // also once per process, instances share the embedded storage
+            const auto start = juce::Time::getHighResolutionTicks();
+            const RNBO::BinaryData& data = SharedBinaryData::getEmbedded();
+            binaryDataMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+            juce::ignoreUnused(data);
+        }
+
+        // what a plugin scan does: create, ask a few questions, delete, never prepare
+        auto start = juce::Time::getHighResolutionTicks();
+        {
+            std::unique_ptr<juce::AudioProcessor> scanned(createPluginFilter());
+            juce::ignoreUnused(scanned->getName(), scanned->hasEditor(), scanned->getParameters().size());
+        }
+        const double scanMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+
+        start = juce::Time::getHighResolutionTicks();
+        std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+        const double createMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+
+        start = juce::Time::getHighResolutionTicks();
+        processor->setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+        processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+        const double prepareMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+
+        start = juce::Time::getHighResolutionTicks();
+        std::unique_ptr<juce::AudioProcessorEditor> editor(processor->createEditorIfNeeded());
+        const double editorMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+
+        // the controls are built when the editor first goes on screen, so opening it in a host
+        // costs construction plus this; -1 when there's no display to show it on
+        double firstShowMicros = -1.0, firstPaintMicros = -1.0;
+        start = juce::Time::getHighResolutionTicks();
+        if (editor != nullptr && showOnDesktop(*editor)) {
+            firstShowMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+
+            start = juce::Time::getHighResolutionTicks();
+            juce::ignoreUnused(editor->createComponentSnapshot(editor->getLocalBounds()));
+            firstPaintMicros = ticksToMicros(juce::Time::getHighResolutionTicks() - start);
+        }
+        editor.reset();
+
+        auto object = new juce::DynamicObject();
+        object->setProperty("breakdown", true);
+        object->setProperty("description_parse_us", descriptionMicros);
+        object->setProperty("binary_data_wrap_us", binaryDataMicros);
+        object->setProperty("scan_us", scanMicros);
+        object->setProperty("create_us", createMicros);
+        object->setProperty("prepare_us", prepareMicros);
+        object->setProperty("editor_us", editorMicros);
+        object->setProperty("editor_first_show_us", firstShowMicros);
+        object->setProperty("editor_first_paint_us", firstPaintMicros);
+        object->setProperty("editor_open_us", firstShowMicros < 0.0 ? -1.0 : editorMicros + firstShowMicros + firstPaintMicros);
+
+        if (! settings.csv) {
+            std::cout << juce::JSON::toString(juce::var(object), true) << std::endl;
+            return;
+        }
+
+        // a table of its own, ahead of the per-instance one and separated by a blank line
+        juce::StringArray names, values;
+        for (const auto& property : object->getProperties()) {
+            if (property.name.toString() == "breakdown")
+                continue;
+            names.add(property.name.toString());
+            values.add(juce::String((double) property.value, 3));
+        }
+        std::cout << names.joinIntoString(",") << "\n" << values.joinIntoString(",") << "\n" << std::endl;
+    }
+
+    void printUsage()
+    {
+        std::cout
+            << "Usage: RNBOInstanceBenchmark [options]\n"
+            << "\n"
+            << "  --instances <n>          largest instance count, doubled from 1 (default 256)\n"
+            << "  --samplerate <hz>        sample rate (default 48000)\n"
+            << "  --blocksize <n>          block size (default 256)\n"
+            << "  --rounds <n>             processing rounds timed per step (default 200)\n"
+            << "  --threads <n>            thread pool size (default number of cores - 1)\n"
+            << "  --editors                also open an editor on screen for every instance\n"
+            << "  --format <fmt>           json or csv (default json)\n"
+            << std::endl;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")) {
+        printUsage();
+        return 0;
+    }
+
+    Settings settings;
+    if (args.containsOption("--instances"))
+        settings.maxInstances = juce::jmax(1, args.getValueForOption("--instances").getIntValue());
+    if (args.containsOption("--samplerate"))
+        settings.sampleRate = args.getValueForOption("--samplerate").getDoubleValue();
+    if (args.containsOption("--blocksize"))
+        settings.blockSize = juce::jmax(1, args.getValueForOption("--blocksize").getIntValue());
+    if (args.containsOption("--rounds"))
+        settings.blocksPerMeasurement = juce::jmax(1, args.getValueForOption("--rounds").getIntValue());
+    if (args.containsOption("--threads"))
+        settings.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+    settings.withEditors = args.containsOption("--editors");
+    settings.csv = args.getValueForOption("--format") == "csv";
+
+    printBreakdown(settings);
+
+    if (settings.withEditors && juce::Desktop::getInstance().getDisplays().getPrimaryDisplay() == nullptr)
+        std::cerr << "No display, the editors are created but never shown, so their controls aren't built" << std::endl;
+
+    if (settings.csv)
+        std::cout << "instances,create_ms,editor_ms,rss_mb,marginal_rss_kb,round_robin_us,marginal_round_robin_us,pool_us,marginal_pool_us" << std::endl;
+
+    std::vector<std::unique_ptr<Instance>> instances;
+    PoolProcessor pool(settings.numThreads);
+
+    const juce::int64 baselineRss = getResidentSetSize();
+    juce::int64 previousRss = baselineRss;
+    double previousRoundRobin = 0.0, previousPool = 0.0;
+    size_t previousCount = 0;
+
+    for (size_t target = 1; previousCount < (size_t) settings.maxInstances; target = juce::jmin(target * 2, (size_t) settings.maxInstances)) {
+        juce::int64 createTicks = 0, editorTicks = 0;
+
+        while (instances.size() < target) {
+            auto instance = std::make_unique<Instance>();
+
+            auto start = juce::Time::getHighResolutionTicks();
+            instance->processor.reset(createPluginFilter());
+            instance->processor->setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+            instance->processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+            createTicks += juce::Time::getHighResolutionTicks() - start;
+
+            if (settings.withEditors) {
+                start = juce::Time::getHighResolutionTicks();
+                instance->editor.reset(instance->processor->createEditorIfNeeded());
+                if (instance->editor != nullptr)
+                    showOnDesktop(*instance->editor);
+                editorTicks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            const int numChannels = juce::jmax(1, instance->processor->getTotalNumInputChannels(), instance->processor->getTotalNumOutputChannels());
+            instance->buffer.setSize(numChannels, settings.blockSize);
+            instances.push_back(std::move(instance));
+        }
+
+        const auto added = (double) (target - previousCount);
+        const juce::int64 rss = getResidentSetSize();
+
+        const double roundRobin = measureRounds(settings.blocksPerMeasurement, [&instances] {
+            for (auto& instance : instances)
+                instance->process();
+        });
+        const double pooled = measureRounds(settings.blocksPerMeasurement, [&pool, &instances] {
+            pool.processRound(instances);
+        });
+
+        const double createMillis = ticksToMicros(createTicks) / 1000.0 / added;
+        const double editorMillis = ticksToMicros(editorTicks) / 1000.0 / added;
+        const double rssMegabytes = (double) (rss - baselineRss) / (1024.0 * 1024.0);
+        const double marginalRssKilobytes = (double) (rss - previousRss) / 1024.0 / added;
+        const double marginalRoundRobin = (roundRobin - previousRoundRobin) / added;
+        const double marginalPool = (pooled - previousPool) / added;
+
+        if (settings.csv) {
+            juce::StringArray fields { juce::String((int) target), juce::String(createMillis, 3), juce::String(editorMillis, 3),
+                                       juce::String(rssMegabytes, 3), juce::String(marginalRssKilobytes, 1),
+                                       juce::String(roundRobin, 3), juce::String(marginalRoundRobin, 3),
+                                       juce::String(pooled, 3), juce::String(marginalPool, 3) };
+            std::cout << fields.joinIntoString(",") << std::endl;
+        } else {
+            auto object = new juce::DynamicObject();
+            object->setProperty("instances", (int) target);
+            object->setProperty("create_ms", createMillis);
+            object->setProperty("editor_ms", editorMillis);
+            object->setProperty("rss_mb", rssMegabytes);
+            object->setProperty("marginal_rss_kb", marginalRssKilobytes);
+            object->setProperty("round_robin_us", roundRobin);
+            object->setProperty("marginal_round_robin_us", marginalRoundRobin);
+            object->setProperty("pool_us", pooled);
+            object->setProperty("marginal_pool_us", marginalPool);
+            object->setProperty("deadline_us", settings.blockSize * 1.0e6 / settings.sampleRate);
+            std::cout << juce::JSON::toString(juce::var(object), true) << std::endl;
+        }
+
+        previousCount = target;
+        previousRss = rss;
+        previousRoundRobin = roundRobin;
+        previousPool = pooled;
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <array>
+
+//==============================================================================
+/*
+    Fixed capacity single producer / single consumer queue for small trivially
+    copyable items. push() and pop() never lock or allocate, so it can be used
+    to hand data between the message thread and the audio thread.
+*/
+template <typename T, int Capacity>
+class LockFreeQueue
+{
+public:
+    // returns false if the queue is full, the item is dropped
+    bool push(const T& item) noexcept
+    {
+        int start1, size1, start2, size2;
+        _fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        _items[(size_t) (size1 > 0 ? start1 : start2)] = item;
+        _fifo.finishedWrite(1);
+        return true;
+    }
+
+    // returns false if the queue is empty
+    bool pop(T& item) noexcept
+    {
+        int start1, size1, start2, size2;
+        _fifo.prepareToRead(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        item = _items[(size_t) (size1 > 0 ? start1 : start2)];
+        _fifo.finishedRead(1);
+        return true;
+    }
+
+    int getNumReady() const noexcept    { return _fifo.getNumReady(); }
+    void reset() noexcept               { _fifo.reset(); }
+
+private:
+    juce::AbstractFifo      _fifo { Capacity };
+    std::array<T, Capacity> _items {};
+
+    JUCE_DECLARE_NON_COPYABLE (LockFreeQueue)
+};
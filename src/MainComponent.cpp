@@ -7,6 +7,10 @@
 #include "RNBO.h"
 #include "RNBO_Utils.h"
 #include "CustomAudioProcessor.h"
+#include "HotSwapProcessor.h"
+#include "PresetFile.h"
+#include "BufferSizeTuner.h"
+#include "MidiIngest.h"
 
 #include <array>
 
@@ -56,7 +60,7 @@ public:
 	}
 };
 
-class MainContentComponent   : public Component, public RNBO::PatcherChangedHandler, public AsyncUpdater
+class MainContentComponent   : public Component, public RNBO::PatcherChangedHandler, public AsyncUpdater, private Timer
 {
 public:
 
@@ -85,17 +89,28 @@ public:
     , _presetLabel("Presets:", "Presets:")
     , _loadPreset("load")
     , _savePreset("save")
+    , _logLoad("log load")
+    , _addMorphSnapshot("+ morph")
+    , _clearMorphSnapshots("clear")
+    , _tuneBufferSize("tune buffer")
     {
+		PropertiesFile::Options options;
+		options.applicationName = ProjectInfo::projectName;
+		options.folderName = ProjectInfo::projectName;
+		options.filenameSuffix = ".settings";
+		options.osxLibrarySubFolder = "Application Support";
+		settings.setOwned (new PropertiesFile (options));
+
 		loadRNBOAudioProcessor();
 
-		RNBO::CoreObject& rnboObject = _audioProcessor->getRnboObject();
+		RNBO::CoreObject& rnboObject = getAudioProcessor()->getRnboObject();
 
 		_deviceManager.initialiseWithDefaultDevices(rnboObject.getNumInputChannels(), rnboObject.getNumOutputChannels());
 
-		// setup our buffer size
+		// setup our buffer size, the one tuned for this device if there is one
 		AudioDeviceManager::AudioDeviceSetup setup;
 		_deviceManager.getAudioDeviceSetup(setup);
-		setup.bufferSize = 128;
+		setup.bufferSize = settings->getIntValue(getBufferSizeKey(), 128);
 		_deviceManager.setAudioDeviceSetup(setup, false);
 
 		_deviceManager.addAudioCallback(&_audioProcessorPlayer);
@@ -106,7 +121,9 @@ public:
 		for (const auto& input : midiInputDevices) {
 			_deviceManager.setMidiInputEnabled(input, true);
 		}
-		_deviceManager.addMidiInputCallback("", &_audioProcessorPlayer);
+		// hardware input goes through the ingest queue, placed by arrival time rather than
+		// at block boundaries. The on-screen keyboard still uses the player's collector.
+		_deviceManager.addMidiInputCallback("", &_midiIngest);
 
 		// setup the midi keyboard
 		_midiKeyboardState.addListener(&_audioProcessorPlayer.getMidiMessageCollector());
@@ -124,6 +141,35 @@ public:
             _loadPreset.onClick = [this]() { loadPreset(); };
             _savePreset.onClick = [this]() { savePreset(); };
 
+            addAndMakeVisible(_logLoad);
+            _logLoad.changeWidthToFitText(20);
+            _logLoad.setClickingTogglesState(true);
+            _logLoad.onClick = [this]() { toggleLoadLog(); };
+
+            // morphing: store the current sound as the next snapshot, then sweep between them
+            addAndMakeVisible(_addMorphSnapshot);
+            addAndMakeVisible(_clearMorphSnapshots);
+            addAndMakeVisible(_morphSlider);
+            _clearMorphSnapshots.changeWidthToFitText(20);
+            _addMorphSnapshot.onClick = [this]() { addMorphSnapshot(); };
+            _clearMorphSnapshots.onClick = [this]() { clearMorphSnapshots(); };
+
+            _morphSlider.setSliderStyle(Slider::LinearHorizontal);
+            _morphSlider.setTextBoxStyle(Slider::NoTextBox, false, 0, 0);
+            _morphSlider.setRange(0.0, 1.0);
+            _morphSlider.onValueChange = [this]() { setMorphPosition((float) _morphSlider.getValue()); };
+            _morphSlider.onDragStart = [this]() { if (auto p = getAudioProcessor()) p->getMorphParameter()->beginChangeGesture(); };
+            _morphSlider.onDragEnd = [this]() { if (auto p = getAudioProcessor()) p->getMorphParameter()->endChangeGesture(); };
+            updateMorphControls();
+
+            addAndMakeVisible(_tuneBufferSize);
+            addAndMakeVisible(_tuneBufferStatus);
+            _tuneBufferSize.changeWidthToFitText(20);
+            _tuneBufferSize.setClickingTogglesState(true);
+            _tuneBufferSize.onClick = [this]() { toggleBufferSizeTuning(); };
+            _bufferSizeTuner.onTrialStarted = [this](int bufferSize) { _tuneBufferStatus.setText("trying " + String(bufferSize) + " samples", dontSendNotification); };
+            _bufferSizeTuner.onFinished = [this](int bufferSize) { bufferSizeTuned(bufferSize); };
+
             addAndMakeVisible (_deviceSelectorComponent);
 			_includesDeviceSelector = true;
 		}
@@ -135,29 +181,50 @@ public:
 
 	void patcherChanged() override
 	{
-		// we can't unload in the middle of the notification
+		// we can't swap in the middle of the notification
 		triggerAsyncUpdate();
 	}
 
 	void handleAsyncUpdate() override
 	{
-		// reload the processor
-		loadRNBOAudioProcessor();
+		// build the new processor in the background and crossfade to it, audio keeps running
+		_hotSwapProcessor->swapAsync([]() { return CustomAudioProcessor::CreateDefault(); });
 	}
 
 	void loadRNBOAudioProcessor()
 	{
 		unloadRNBOAudioProcessor();
 
-		jassert(_audioProcessor.get() == nullptr);
+		jassert(_hotSwapProcessor.get() == nullptr);
+
+		std::unique_ptr<CustomAudioProcessor> processor(CustomAudioProcessor::CreateDefault());
+		_hotSwapProcessor = std::make_unique<HotSwapProcessor>(std::move(processor));
+		_hotSwapProcessor->onProcessorChanged = [this](CustomAudioProcessor* p) { attachEditor(p); };
+		_hotSwapProcessor->setMidiIngest(&_midiIngest);
+
+		_audioProcessorPlayer.setProcessor(_hotSwapProcessor.get());
+
+		attachEditor(getAudioProcessor());
+	}
+
+	// the processor the UI talks to, the newest one while a hot swap is fading over
+	CustomAudioProcessor* getAudioProcessor() const
+	{
+		return _hotSwapProcessor != nullptr ? _hotSwapProcessor->getProcessor() : nullptr;
+	}
+
+	void attachEditor(CustomAudioProcessor* processor)
+	{
+		detachEditor();
 
-		_audioProcessor = std::unique_ptr<CustomAudioProcessor>(CustomAudioProcessor::CreateDefault());
-		RNBO::CoreObject& rnboObject = _audioProcessor->getRnboObject();
+		RNBO::CoreObject& rnboObject = processor->getRnboObject();
 		rnboObject.setPatcherChangedHandler(this);
 
-		_audioProcessorPlayer.setProcessor(_audioProcessor.get());
+		// a swapped in processor morphs between the same snapshots, from where we were
+		processor->setMorphSnapshots(_morphSnapshots);
+		processor->getMorphParameter()->setValueNotifyingHost((float) _morphSlider.getValue());
 
-		_audioProcessorEditor.reset(_audioProcessor->createEditorIfNeeded());
+		_audioProcessorEditor.reset(processor->createEditorIfNeeded());
 		if (_audioProcessorEditor) {
 			addAndMakeVisible(_audioProcessorEditor.get());
 			resized();  // set up the sizes
@@ -168,27 +235,36 @@ public:
 		}
 	}
 
+	void detachEditor()
+	{
+		if (_audioProcessorEditor) {
+			_audioProcessorEditor->getAudioProcessor()->editorBeingDeleted(_audioProcessorEditor.get());
+			_audioProcessorEditor.reset();
+		}
+	}
+
 	void unloadRNBOAudioProcessor()
 	{
-		if (_audioProcessor) {
+		if (_hotSwapProcessor) {
 			_audioProcessorPlayer.setProcessor(nullptr);
-			if (_audioProcessorEditor) {
-				_audioProcessor->editorBeingDeleted(_audioProcessorEditor.get());
-			}
-			_audioProcessorEditor.reset();
-			_audioProcessor.reset();
+			detachEditor();
+			_hotSwapProcessor.reset();
 		}
 	}
 
 	void shutdownAudio()
 	{
 		unloadRNBOAudioProcessor();
+		_deviceManager.removeMidiInputCallback("", &_midiIngest);
 		_deviceManager.removeAudioCallback(&_audioProcessorPlayer);
 		_deviceManager.closeAudioDevice();
 	}
 
 	~MainContentComponent()
     {
+		// let a preset that's being written finish, reads still in flight are dropped
+		_presetThread.removeAllJobs (false, 5000);
+		stopLoadLog();
 		shutdownAudio();
     }
 
@@ -212,8 +288,20 @@ public:
             _presetLabel.setBounds(5, 5, _presetLabel.getFont().getStringWidth(_presetLabel.getText()) + 10, 20);
             _loadPreset.setTopLeftPosition(_presetLabel.getWidth() + 10, 5);
             _savePreset.setTopLeftPosition(_presetLabel.getWidth() + 5 + _loadPreset.getWidth() + 10, 5);
+            _logLoad.setTopLeftPosition(_savePreset.getRight() + 15, 5);
+
+            const int morphY = _loadPreset.getBottom() + 5;
+            _addMorphSnapshot.setTopLeftPosition(5, morphY);
+            _clearMorphSnapshots.setTopLeftPosition(_addMorphSnapshot.getRight() + 5, morphY);
+            _morphSlider.setBounds(_clearMorphSnapshots.getRight() + 5, morphY,
+                                   selectorWidth - _clearMorphSnapshots.getRight() - 10, _addMorphSnapshot.getHeight());
+
+            const int tuneY = _addMorphSnapshot.getBottom() + 5;
+            _tuneBufferSize.setTopLeftPosition(5, tuneY);
+            _tuneBufferStatus.setBounds(_tuneBufferSize.getRight() + 5, tuneY,
+                                        selectorWidth - _tuneBufferSize.getRight() - 10, _tuneBufferSize.getHeight());
 			usedSelectorWidth = std::min(getWidth(), selectorWidth);
-			_deviceSelectorComponent.setBounds(0, _loadPreset.getHeight() + 10, usedSelectorWidth, getHeight());
+			_deviceSelectorComponent.setBounds(0, _tuneBufferSize.getBottom() + 5, usedSelectorWidth, getHeight());
 		}
 
 		if (_audioProcessorEditor) {
@@ -235,18 +323,63 @@ public:
                 return;
 
             setLastFile (fc);
+            readPresetAsync (fc.getResult());
+        });
+    }
 
+    // Reading and decoding happen on the preset thread. Only handing the decoded values to the
+    // processor comes back to the message thread, and the audio thread picks them up lock-free.
+    void readPresetAsync (const File& file)
+    {
+        Component::SafePointer<MainContentComponent> safeThis (this);
+
+        _presetThread.addJob ([safeThis, file]
+        {
             MemoryBlock data;
+            std::vector<PresetFile::Parameter> parameters;
+            String error;
+
+            const bool loaded = file.loadFileAsData (data);
+            const bool isPreset = loaded && PresetFile::hasPresetHeader (data);
+            const bool decoded = isPreset && PresetFile::decode (data, parameters, error);
+
+            MessageManager::callAsync ([safeThis, loaded, isPreset, decoded, data = std::move (data),
+                                        parameters = std::move (parameters), error]
+            {
+                if (safeThis == nullptr || safeThis->getAudioProcessor() == nullptr)
+                    return;
+
+                if (! loaded)
+                    showPresetError (TRANS("Error whilst loading"), TRANS("Couldn't read from the specified file!"));
+                else if (decoded)
+                    safeThis->getAudioProcessor()->schedulePreset (parameters);
+                else if (isPreset)
+                    showPresetError (TRANS("Error whilst loading"), error);
+                else // state saved before presets had their own format
+                    safeThis->getAudioProcessor()->setStateInformation (data.getData(), (int) data.getSize());
+            });
+        });
+    }
 
-            if (fc.getResult().loadFileAsData (data))
-                _audioProcessor->setStateInformation (data.getData(), (int) data.getSize());
-            else
-                AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon,
-                                                  TRANS("Error whilst loading"),
-                                                  TRANS("Couldn't read from the specified file!"));
+    void writePresetAsync (const File& file)
+    {
+        // reading the current values is cheap, encoding, compressing and writing are not
+        auto parameters = getAudioProcessor()->captureParameters();
+
+        _presetThread.addJob ([file, parameters = std::move (parameters)]
+        {
+            auto data = PresetFile::encode (parameters, true);
+
+            if (! file.replaceWithData (data.getData(), data.getSize()))
+                MessageManager::callAsync ([] { showPresetError (TRANS("Error whilst saving"), TRANS("Couldn't write to the specified file!")); });
         });
     }
 
+    static void showPresetError (const String& title, const String& message)
+    {
+        AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, title, message);
+    }
+
     static String getFilePatterns (const String& fileSuffix)
     {
         if (fileSuffix.isEmpty())
@@ -288,26 +421,164 @@ public:
                 return;
 
             setLastFile (fc);
+            writePresetAsync (fc.getResult());
+        });
+    }
 
-            MemoryBlock data;
-            _audioProcessor->getStateInformation (data);
+    //=======================================================================
+    // The snapshots live here rather than in the processor so they survive a hot swap
+    void addMorphSnapshot()
+    {
+        if (getAudioProcessor() == nullptr || (int) _morphSnapshots.size() >= PresetMorpher::maxSnapshots)
+            return;
+
+        _morphSnapshots.push_back(getAudioProcessor()->captureParameters());
+        getAudioProcessor()->setMorphSnapshots(_morphSnapshots);
+        updateMorphControls();
+    }
+
+    void clearMorphSnapshots()
+    {
+        _morphSnapshots.clear();
+        if (getAudioProcessor() != nullptr)
+            getAudioProcessor()->setMorphSnapshots(_morphSnapshots);
+        updateMorphControls();
+    }
+
+    void setMorphPosition(float position)
+    {
+        if (auto processor = getAudioProcessor())
+            processor->getMorphParameter()->setValueNotifyingHost(position);
+    }
+
+    void updateMorphControls()
+    {
+        _addMorphSnapshot.setButtonText("+ morph (" + String((int) _morphSnapshots.size()) + ")");
+        _addMorphSnapshot.changeWidthToFitText(20);
+        _addMorphSnapshot.setEnabled((int) _morphSnapshots.size() < PresetMorpher::maxSnapshots);
+        _morphSlider.setEnabled(_morphSnapshots.size() >= 2);
+        resized();
+    }
+
+    //=======================================================================
+    // Steps the buffer size down on the open device until the processor starts to struggle,
+    // then keeps the smallest size that held up, remembered per device
+    void toggleBufferSizeTuning()
+    {
+        if (_bufferSizeTuner.isRunning()) {
+            _bufferSizeTuner.cancel();
+            _tuneBufferStatus.setText("cancelled", dontSendNotification);
+        }
+        else if (! _bufferSizeTuner.start()) {
+            _tuneBufferStatus.setText("nothing smaller to try", dontSendNotification);
+        }
+
+        _tuneBufferSize.setToggleState(_bufferSizeTuner.isRunning(), dontSendNotification);
+    }
 
-            if (! fc.getResult().replaceWithData (data.getData(), data.getSize()))
+    void bufferSizeTuned(int bufferSize)
+    {
+        settings->setValue(getBufferSizeKey(), bufferSize);
+        _tuneBufferStatus.setText("using " + String(bufferSize) + " samples", dontSendNotification);
+        _tuneBufferSize.setToggleState(false, dontSendNotification);
+    }
+
+    // drivers differ wildly, so the tuned size belongs to the device it was found on
+    String getBufferSizeKey() const
+    {
+        AudioDeviceManager::AudioDeviceSetup setup;
+        _deviceManager.getAudioDeviceSetup(setup);
+        return "bufferSize." + _deviceManager.getCurrentAudioDeviceType() + "." + setup.outputDeviceName;
+    }
+
+    //=======================================================================
+    // Streams the processor's load meter and the MIDI timing stats to a file once a second,
+    // as CSV or as one JSON object per line depending on the file extension
+    void toggleLoadLog()
+    {
+        if (_loadLogStream != nullptr) {
+            stopLoadLog();
+            return;
+        }
+
+        // the button only shows as on once logging actually started
+        _logLoad.setToggleState(false, dontSendNotification);
+
+        stateFileChooser = std::make_unique<FileChooser> (TRANS("Log DSP load"),
+                                                          File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("dsp-load.csv"),
+                                                          "*.csv;*.json");
+        auto flags = FileBrowserComponent::saveMode
+                   | FileBrowserComponent::canSelectFiles
+                   | FileBrowserComponent::warnAboutOverwriting;
+
+        stateFileChooser->launchAsync (flags, [this] (const FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (file == File{})
+                return;
+
+            file.deleteFile();
+            auto stream = std::make_unique<FileOutputStream> (file);
+
+            if (stream->failedToOpen()) {
                 AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon,
-                                                  TRANS("Error whilst saving"),
+                                                  TRANS("Error whilst logging"),
                                                   TRANS("Couldn't write to the specified file!"));
+                return;
+            }
+
+            _loadLogIsJson = file.hasFileExtension ("json");
+            if (! _loadLogIsJson)
+                *stream << "time," << AudioLoadMeter::Snapshot::getCsvHeader() << "," << MidiIngest::Stats::getCsvHeader() << newLine;
+
+            _loadLogStream = std::move (stream);
+            _loadLogStartMs = Time::getMillisecondCounterHiRes();
+            _logLoad.setToggleState(true, dontSendNotification);
+            startTimer (1000);
         });
     }
 
+    void stopLoadLog()
+    {
+        stopTimer();
+        _loadLogStream.reset();
+        _logLoad.setToggleState(false, dontSendNotification);
+    }
+
+    void timerCallback() override
+    {
+        if (_loadLogStream == nullptr || getAudioProcessor() == nullptr)
+            return;
+
+        const double seconds = (Time::getMillisecondCounterHiRes() - _loadLogStartMs) / 1000.0;
+        auto snapshot = getAudioProcessor()->getLoadMeter().getSnapshot();
+        auto midiStats = _midiIngest.getStats();
+
+        if (_loadLogIsJson) {
+            auto line = snapshot.toVar();
+            line.getDynamicObject()->setProperty ("time", seconds);
+
+            for (const auto& property : midiStats.toVar().getDynamicObject()->getProperties())
+                line.getDynamicObject()->setProperty (property.name, property.value);
+            *_loadLogStream << JSON::toString (line, true) << newLine;
+        }
+        else {
+            *_loadLogStream << String (seconds, 3) << "," << snapshot.toCsvRow() << "," << midiStats.toCsvRow() << newLine;
+        }
+
+        _loadLogStream->flush();
+    }
+
 private:
     //==============================================================================
 
 	AudioDeviceManager		_deviceManager;
 	AudioProcessorPlayer	_audioProcessorPlayer;
+	MidiIngest				_midiIngest;
 
 	std::unique_ptr<GrabFocusWhenShownComponentMovementWatcher> _keyboardFocusGrabber;
 
-	std::unique_ptr<CustomAudioProcessor>		_audioProcessor;
+	std::unique_ptr<HotSwapProcessor>			_hotSwapProcessor;
 	std::unique_ptr<AudioProcessorEditor>		_audioProcessorEditor;
 
 	// midi keyboard stuff
@@ -321,10 +592,29 @@ private:
     juce::Label         _presetLabel;
     juce::TextButton    _loadPreset;
     juce::TextButton    _savePreset;
+    juce::TextButton    _logLoad;
+
+    juce::TextButton    _addMorphSnapshot;
+    juce::TextButton    _clearMorphSnapshots;
+    juce::Slider        _morphSlider;
+    std::vector<PresetMorpher::Snapshot> _morphSnapshots;
+
+    juce::TextButton    _tuneBufferSize;
+    juce::Label         _tuneBufferStatus;
+
+    std::unique_ptr<FileOutputStream> _loadLogStream;
+    bool                _loadLogIsJson = false;
+    double              _loadLogStartMs = 0.0;
 
     std::unique_ptr<FileChooser> stateFileChooser;
+    ThreadPool          _presetThread { 1 };
     OptionalScopedPointer<PropertySet> settings;
 
+    BufferSizeTuner     _bufferSizeTuner { _deviceManager, [this]() -> AudioLoadMeter* {
+        auto processor = getAudioProcessor();
+        return processor != nullptr ? &processor->getLoadMeter() : nullptr;
+    } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
 };
 
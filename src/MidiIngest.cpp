@@ -0,0 +1,90 @@
+#include "MidiIngest.h"
+
+#include <cmath>
+
+void MidiIngest::handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message)
+{
+    const int size = message.getRawDataSize();
+    if (size <= 0 || size > 3) {
+        _numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // drivers stamp in seconds on the getMillisecondCounterHiRes() clock, a few don't stamp at all
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const double stamped = message.getTimeStamp() * 1000.0;
+
+    Event event;
+    memcpy(event.data, message.getRawData(), (size_t) size);
+    event.size = size;
+    event.arrivalMs = (stamped > 0.0 && std::abs(now - stamped) < 1000.0) ? stamped : now;
+
+    bool pushed;
+    {
+        const juce::SpinLock::ScopedLockType lock(_pushLock);
+        pushed = _queue.push(event);
+    }
+
+    if (! pushed)
+        _numDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MidiIngest::renderNextBlock(juce::MidiBuffer& midiMessages, int numSamples, double sampleRate)
+{
+    if (_resetRequested.exchange(false, std::memory_order_acquire)) {
+        _numEvents.store(0, std::memory_order_relaxed);
+        _numLate.store(0, std::memory_order_relaxed);
+        _numDropped.store(0, std::memory_order_relaxed);
+        _latencySum.store(0.0, std::memory_order_relaxed);
+        _latencySquareSum.store(0.0, std::memory_order_relaxed);
+        _maxLatency.store(0.0, std::memory_order_relaxed);
+    }
+
+    _clock.beginBlock(numSamples, sampleRate);
+
+    uint64_t numEvents = _numEvents.load(std::memory_order_relaxed);
+    uint64_t numLate = _numLate.load(std::memory_order_relaxed);
+    double latencySum = _latencySum.load(std::memory_order_relaxed);
+    double latencySquareSum = _latencySquareSum.load(std::memory_order_relaxed);
+    double maxLatency = _maxLatency.load(std::memory_order_relaxed);
+
+    Event event;
+    while (_queue.pop(event)) {
+        bool late = false;
+        const int offset = _clock.getSampleOffset(event.arrivalMs, late);
+        midiMessages.addEvent(event.data, event.size, offset);
+
+        // against the callback's real start, so callback jitter shows up in the spread
+        const double latency = _clock.getMeasuredSampleTimeMs(offset) - event.arrivalMs;
+        numEvents++;
+        numLate += late ? 1 : 0;
+        latencySum += latency;
+        latencySquareSum += latency * latency;
+        maxLatency = juce::jmax(maxLatency, latency);
+    }
+
+    _numLate.store(numLate, std::memory_order_relaxed);
+    _latencySum.store(latencySum, std::memory_order_relaxed);
+    _latencySquareSum.store(latencySquareSum, std::memory_order_relaxed);
+    _maxLatency.store(maxLatency, std::memory_order_relaxed);
+    _numEvents.store(numEvents, std::memory_order_release);
+}
+
+MidiIngest::Stats MidiIngest::getStats() const
+{
+    Stats stats;
+    stats.numEvents = _numEvents.load(std::memory_order_acquire);
+    stats.numLate = _numLate.load(std::memory_order_relaxed);
+    stats.numDropped = _numDropped.load(std::memory_order_relaxed);
+    stats.maxLatencyMs = _maxLatency.load(std::memory_order_relaxed);
+
+    if (stats.numEvents > 0) {
+        const double count = (double) stats.numEvents;
+        stats.meanLatencyMs = _latencySum.load(std::memory_order_relaxed) / count;
+
+        const double variance = _latencySquareSum.load(std::memory_order_relaxed) / count - stats.meanLatencyMs * stats.meanLatencyMs;
+        stats.jitterMs = std::sqrt(juce::jmax(0.0, variance));
+    }
+
+    return stats;
+}
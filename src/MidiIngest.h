@@ -0,0 +1,97 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "BlockClock.h"
+#include "LockFreeQueue.h"
+
+#include <atomic>
+
+//==============================================================================
+/*
+    Hardware MIDI input placed by arrival time instead of block boundaries.
+
+    The MIDI input threads push each short message with the timestamp the driver gave
+    it. The audio thread places it in the next block at the matching sample offset
+    (see BlockClock), so a played phrase keeps its timing whatever the buffer size,
+    at a constant latency of one block.
+
+    Stats are measured per event, from arrival (the driver's timestamp where there is
+    one) to when the sample it was placed at is processed, counted from the time the
+    audio callback actually started, not from BlockClock's smoothed prediction. The
+    spread is what's left of input and callback jitter after placement. The output
+    device's own latency isn't included. System exclusive and other long messages are
+    dropped, since the drone has no use for them.
+*/
+class MidiIngest : public juce::MidiInputCallback
+{
+public:
+    static constexpr int capacity = 1024;
+
+    struct Stats
+    {
+        uint64_t numEvents = 0;
+        uint64_t numLate = 0;       // arrived more than a block before their block, placed at its start
+        uint64_t numDropped = 0;    // queue full, or too long to queue
+        double meanLatencyMs = 0.0;
+        double jitterMs = 0.0;      // standard deviation of the latency
+        double maxLatencyMs = 0.0;
+
+        static juce::String getCsvHeader()
+        {
+            return "midi_events,midi_late,midi_dropped,midi_latency_ms,midi_jitter_ms,midi_max_latency_ms";
+        }
+
+        juce::String toCsvRow() const
+        {
+            return juce::String((juce::int64) numEvents) + "," + juce::String((juce::int64) numLate) + ","
+                 + juce::String((juce::int64) numDropped) + "," + juce::String(meanLatencyMs, 3) + ","
+                 + juce::String(jitterMs, 3) + "," + juce::String(maxLatencyMs, 3);
+        }
+
+        juce::var toVar() const
+        {
+            auto object = new juce::DynamicObject();
+            object->setProperty("midi_events", (juce::int64) numEvents);
+            object->setProperty("midi_late", (juce::int64) numLate);
+            object->setProperty("midi_dropped", (juce::int64) numDropped);
+            object->setProperty("midi_latency_ms", meanLatencyMs);
+            object->setProperty("midi_jitter_ms", jitterMs);
+            object->setProperty("midi_max_latency_ms", maxLatencyMs);
+            return juce::var(object);
+        }
+    };
+
+    // MIDI input threads
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+
+    // Audio thread, before the block is processed. Adds what arrived since the last block.
+    void renderNextBlock(juce::MidiBuffer& midiMessages, int numSamples, double sampleRate);
+
+    // Any thread
+    Stats getStats() const;
+    void resetStats() noexcept  { _resetRequested.store(true, std::memory_order_release); }
+
+private:
+    struct Event
+    {
+        juce::uint8 data[3];
+        int size;
+        double arrivalMs;
+    };
+
+    // each input device may call back on its own thread, the queue takes one producer at a time
+    juce::SpinLock                  _pushLock;
+    LockFreeQueue<Event, capacity>  _queue;
+
+    // audio thread
+    BlockClock                      _clock;
+
+    // written by the audio thread only, the dropped count by the input threads
+    std::atomic<uint64_t>           _numEvents { 0 };
+    std::atomic<uint64_t>           _numLate { 0 };
+    std::atomic<uint64_t>           _numDropped { 0 };
+    std::atomic<double>             _latencySum { 0.0 };
+    std::atomic<double>             _latencySquareSum { 0.0 };
+    std::atomic<double>             _maxLatency { 0.0 };
+    std::atomic<bool>               _resetRequested { false };
+};
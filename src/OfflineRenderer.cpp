@@ -0,0 +1,191 @@
+#include "OfflineRenderer.h"
+
+#include <algorithm>
+
+OfflineRenderer::OfflineRenderer(CustomAudioProcessor& processor, const Settings& settings)
+    : _processor(processor)
+    , _settings(settings)
+{
+    _processor.setNonRealtime(true);
+    _processor.setRateAndBufferSizeDetails(_settings.sampleRate, _settings.blockSize);
+    _processor.prepareToPlay(_settings.sampleRate, _settings.blockSize);
+
+    // the processor expects a buffer large enough for both its inputs and outputs
+    const int numChannels = juce::jmax(1, _processor.getTotalNumInputChannels(), _processor.getTotalNumOutputChannels());
+    _buffer.setSize(numChannels, _settings.blockSize);
+    _midi.ensureSize(4096);
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    _processor.releaseResources();
+}
+
+bool OfflineRenderer::loadParameterScript(const juce::File& file, juce::String& error)
+{
+    if (! file.existsAsFile()) {
+        error = "Parameter script not found: " + file.getFullPathName();
+        return false;
+    }
+
+    juce::StringArray lines;
+    file.readLines(lines);
+
+    for (int i = 0; i < lines.size(); i++) {
+        auto line = lines[i].trim();
+        if (line.isEmpty() || line.startsWithChar('#'))
+            continue;
+
+        auto tokens = juce::StringArray::fromTokens(line, " \t", "");
+        tokens.removeEmptyStrings();
+
+        if (tokens.size() != 3) {
+            error = "Line " + juce::String(i + 1) + ": expected \"<seconds> <parameter id> <value>\"";
+            return false;
+        }
+
+        if (! addParameterEvent(tokens[0].getDoubleValue(), tokens[1], tokens[2].getDoubleValue())) {
+            error = "Line " + juce::String(i + 1) + ": unknown parameter \"" + tokens[1] + "\"";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool OfflineRenderer::addParameterEvent(double timeInSeconds, const juce::String& parameterId, double value)
+{
+    RNBO::ParameterIndex index = _processor.getRnboObject().getParameterIndexForID(parameterId.toRawUTF8());
+    if (index == -1)
+        return false;
+
+    ParameterEvent event { juce::roundToInt64(juce::jmax(0.0, timeInSeconds) * _settings.sampleRate), index, value };
+
+    // keep the list ordered by time, events at the same time keep their script order
+    auto position = std::upper_bound(_parameterEvents.begin(), _parameterEvents.end(), event,
+                                     [](const ParameterEvent& a, const ParameterEvent& b) { return a.sample < b.sample; });
+    _parameterEvents.insert(position, event);
+    return true;
+}
+
+bool OfflineRenderer::loadMidiFile(const juce::File& file, juce::String& error)
+{
+    juce::FileInputStream stream(file);
+    if (! stream.openedOk()) {
+        error = "Couldn't open MIDI file: " + file.getFullPathName();
+        return false;
+    }
+
+    juce::MidiFile midiFile;
+    if (! midiFile.readFrom(stream)) {
+        error = "Couldn't parse MIDI file: " + file.getFullPathName();
+        return false;
+    }
+
+    midiFile.convertTimestampTicksToSeconds();
+
+    juce::MidiMessageSequence sequence;
+    for (int track = 0; track < midiFile.getNumTracks(); track++)
+        sequence.addSequence(*midiFile.getTrack(track), 0.0);
+
+    setMidiSequence(sequence);
+    return true;
+}
+
+void OfflineRenderer::setMidiSequence(const juce::MidiMessageSequence& sequenceInSeconds)
+{
+    _midiSequence = sequenceInSeconds;
+    _midiSequence.sort();
+    _nextMidiEvent = 0;
+}
+
+int OfflineRenderer::processNextBlock()
+{
+    const int numSamples = _settings.blockSize;
+    const juce::int64 blockEnd = _position + numSamples;
+
+    applyParameterEvents(blockEnd);
+    collectMidi(blockEnd);
+
+    _buffer.clear();
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    _processor.processBlock(_buffer, _midi);
+    _lastBlockTicks = juce::Time::getHighResolutionTicks() - start;
+
+    _position = blockEnd;
+    return numSamples;
+}
+
+bool OfflineRenderer::renderToFile(const juce::File& file, juce::int64 numSamples, int bitsPerSample, juce::String& error)
+{
+    file.deleteFile();
+
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+    if (stream == nullptr || ! stream->openedOk()) {
+        error = "Couldn't write to " + file.getFullPathName();
+        return false;
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(),
+                                                                        _settings.sampleRate,
+                                                                        (unsigned int) juce::jmax(1, getNumOutputChannels()),
+                                                                        bitsPerSample,
+                                                                        {},
+                                                                        0));
+    if (writer == nullptr) {
+        error = "Couldn't create a " + juce::String(bitsPerSample) + " bit WAV writer";
+        return false;
+    }
+    stream.release(); // the writer owns the stream now
+
+    juce::int64 remaining = numSamples;
+    while (remaining > 0) {
+        const int rendered = processNextBlock();
+        const int toWrite = (int) juce::jmin((juce::int64) rendered, remaining);
+
+        if (! writer->writeFromAudioSampleBuffer(_buffer, 0, toWrite)) {
+            error = "Write error in " + file.getFullPathName();
+            return false;
+        }
+        remaining -= toWrite;
+    }
+
+    return true;
+}
+
+void OfflineRenderer::applyParameterEvents(juce::int64 blockEnd)
+{
+    RNBO::CoreObject& coreObject = _processor.getRnboObject();
+
+    // timestamped at their sample, RNBO applies them there while it processes the block, so the
+    // output doesn't depend on the block size
+    const RNBO::MillisecondTime blockStart = coreObject.getCurrentTime();
+    const double millisecondsPerSample = 1000.0 / _settings.sampleRate;
+
+    while (_nextParameterEvent < _parameterEvents.size() && _parameterEvents[_nextParameterEvent].sample < blockEnd) {
+        const auto& event = _parameterEvents[_nextParameterEvent++];
+        const juce::int64 offset = juce::jmax((juce::int64) 0, event.sample - _position);
+        coreObject.setParameterValue(event.index, event.value, blockStart + (double) offset * millisecondsPerSample);
+    }
+}
+
+void OfflineRenderer::collectMidi(juce::int64 blockEnd)
+{
+    _midi.clear();
+
+    while (_nextMidiEvent < _midiSequence.getNumEvents()) {
+        const auto& message = _midiSequence.getEventPointer(_nextMidiEvent)->message;
+        const juce::int64 sample = juce::roundToInt64(message.getTimeStamp() * _settings.sampleRate);
+        if (sample >= blockEnd)
+            break;
+
+        _nextMidiEvent++;
+        if (message.isMetaEvent())
+            continue;
+
+        const int offset = (int) juce::jlimit((juce::int64) 0, (juce::int64) _settings.blockSize - 1, sample - _position);
+        _midi.addEvent(message, offset);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+
+#include <vector>
+
+//==============================================================================
+/*
+    Drives a CustomAudioProcessor without an audio device. Blocks are processed
+    back to back as fast as the CPU allows, with parameter automation and MIDI
+    applied from pre-loaded event lists.
+*/
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+    };
+
+    OfflineRenderer(CustomAudioProcessor& processor, const Settings& settings);
+    ~OfflineRenderer();
+
+    // Parameter automation script: one "<seconds> <parameter id> <value>" entry per line,
+    // values are in the parameter's own (not normalized) range. Lines starting with # are ignored.
+    bool loadParameterScript(const juce::File& file, juce::String& error);
+    bool addParameterEvent(double timeInSeconds, const juce::String& parameterId, double value);
+
+    // Standard MIDI file, all tracks are merged
+    bool loadMidiFile(const juce::File& file, juce::String& error);
+    void setMidiSequence(const juce::MidiMessageSequence& sequenceInSeconds);
+
+    // Processes the next block into getOutput() and returns the number of samples rendered
+    int processNextBlock();
+
+    // Renders numSamples into a WAV file with the processor's output channel count
+    bool renderToFile(const juce::File& file, juce::int64 numSamples, int bitsPerSample, juce::String& error);
+
+    const juce::AudioBuffer<float>& getOutput() const   { return _buffer; }
+    int getNumOutputChannels() const                    { return _processor.getTotalNumOutputChannels(); }
+    juce::int64 getPosition() const                     { return _position; }
+    const Settings& getSettings() const                 { return _settings; }
+
+    // High resolution ticks spent inside processBlock for the last block
+    juce::int64 getLastBlockTicks() const               { return _lastBlockTicks; }
+
+private:
+    struct ParameterEvent
+    {
+        juce::int64 sample;
+        RNBO::ParameterIndex index;
+        double value;
+    };
+
+    void applyParameterEvents(juce::int64 blockEnd);
+    void collectMidi(juce::int64 blockEnd);
+
+    CustomAudioProcessor&           _processor;
+    Settings                        _settings;
+
+    juce::AudioBuffer<float>        _buffer;
+    juce::MidiBuffer                _midi;
+
+    std::vector<ParameterEvent>     _parameterEvents;
+    size_t                          _nextParameterEvent = 0;
+
+    juce::MidiMessageSequence       _midiSequence;
+    int                             _nextMidiEvent = 0;
+
+    juce::int64                     _position = 0;
+    juce::int64                     _lastBlockTicks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
@@ -0,0 +1,137 @@
+#include "OutportEventBus.h"
+
+#include <algorithm>
+
+void OutportEventBus::setTags(const juce::StringArray& tags)
+{
+    _tags = tags;
+    _slots.reset(new Slot[(size_t) juce::jmax(1, _tags.size())]);
+    _anyDirty.store(false);
+}
+
+int OutportEventBus::findSlot(RNBO::MessageTag messageTag, const char* tagName) noexcept
+{
+    for (int i = 0; i < _tags.size(); i++) {
+        if (_slots[(size_t) i].messageTagKnown && _slots[(size_t) i].messageTag == messageTag)
+            return i;
+    }
+
+    if (tagName == nullptr)
+        return -1;
+
+    // first message for this tag, a string compare that doesn't allocate
+    for (int i = 0; i < _tags.size(); i++) {
+        if (! _slots[(size_t) i].messageTagKnown && _tags[i] == tagName) {
+            _slots[(size_t) i].messageTag = messageTag;
+            _slots[(size_t) i].messageTagKnown = true;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool OutportEventBus::post(const RNBO::MessageEvent& event, const char* tagName) noexcept
+{
+    const int index = findSlot(event.getTag(), tagName);
+    if (index < 0)
+        return false;
+
+    Slot& slot = _slots[(size_t) index];
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    switch (event.getType()) {
+        case RNBO::MessageEvent::Number:
+            slot.type.store(Event::Number, std::memory_order_relaxed);
+            slot.numValues.store(1, std::memory_order_relaxed);
+            slot.values[0].store(event.getNumValue(), std::memory_order_relaxed);
+            break;
+
+        case RNBO::MessageEvent::List: {
+            const auto list = event.getListValue();
+            const int numValues = list != nullptr ? juce::jmin(maxListValues, (int) list->length) : 0;
+
+            slot.type.store(Event::List, std::memory_order_relaxed);
+            slot.numValues.store(numValues, std::memory_order_relaxed);
+            for (int i = 0; i < numValues; i++) {
+                slot.values[(size_t) i].store((*list)[(size_t) i], std::memory_order_relaxed);
+            }
+            break;
+        }
+
+        default:
+            slot.type.store(Event::Bang, std::memory_order_relaxed);
+            slot.numValues.store(0, std::memory_order_relaxed);
+            break;
+    }
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+
+    slot.numPosted.fetch_add(1, std::memory_order_relaxed);
+    slot.dirty.store(true, std::memory_order_release);
+    _anyDirty.store(true, std::memory_order_release);
+    return true;
+}
+
+OutportEventBus::Event OutportEventBus::readSlot(Slot& slot) const noexcept
+{
+    Event event;
+
+    // the producer only holds the slot for a few stores, retrying is cheaper than locking it
+    for (;;) {
+        const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+            continue;
+
+        event.type = (Event::Type) slot.type.load(std::memory_order_relaxed);
+        event.numValues = slot.numValues.load(std::memory_order_relaxed);
+        for (int i = 0; i < event.numValues; i++) {
+            event.values[(size_t) i] = slot.values[(size_t) i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+            return event;
+    }
+}
+
+int OutportEventBus::subscribe(const juce::String& tag, Callback callback)
+{
+    const int slot = _tags.indexOf(tag);
+    if (slot < 0 || callback == nullptr)
+        return -1;
+
+    const int id = _nextSubscriptionId++;
+    _subscriptions.push_back({ id, slot, std::move(callback) });
+    return id;
+}
+
+void OutportEventBus::unsubscribe(int subscriptionId)
+{
+    _subscriptions.erase(std::remove_if(_subscriptions.begin(), _subscriptions.end(),
+                                        [subscriptionId](const Subscription& s) { return s.id == subscriptionId; }),
+                         _subscriptions.end());
+}
+
+void OutportEventBus::drain()
+{
+    if (! _anyDirty.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    for (int i = 0; i < _tags.size(); i++) {
+        Slot& slot = _slots[(size_t) i];
+        if (! slot.dirty.exchange(false, std::memory_order_acquire))
+            continue;
+
+        Event event = readSlot(slot);
+        event.numCoalesced = juce::jmax(1u, slot.numPosted.exchange(0, std::memory_order_relaxed));
+
+        for (const auto& subscription : _subscriptions) {
+            if (subscription.slot == i)
+                subscription.callback(event);
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    Outport messages from the RNBO object to the interface, by tag.
+
+    Each outport gets a slot up front. post() writes the newest message into its
+    tag's slot without locking or allocating, whatever thread the RNBO object
+    delivers on. The message thread drains the bus once per animation frame. Each
+    subscriber of a tag then sees only the latest message, plus how many arrived
+    since the last drain. A patch sending a meter or an envelope every block costs
+    the interface one callback per frame, not one per block.
+
+    Bangs, numbers and lists of up to maxListValues are kept. Longer lists are
+    truncated. Messages to tags the bus wasn't set up with are dropped.
+*/
+class OutportEventBus
+{
+public:
+    static constexpr int maxListValues = 8;
+
+    struct Event
+    {
+        enum Type { Bang, Number, List };
+
+        Type type = Bang;
+        int numValues = 0;                              // 1 for a number
+        std::array<double, maxListValues> values {};
+        uint32_t numCoalesced = 1;                      // messages since the last drain, this is the newest
+
+        double getNumber() const    { return numValues > 0 ? values[0] : 0.0; }
+    };
+
+    using Callback = std::function<void(const Event&)>;
+
+    // Not thread safe, call before any messages arrive
+    void setTags(const juce::StringArray& tags);
+    const juce::StringArray& getTags() const    { return _tags; }
+
+    // One thread at a time. tagName is the resolved name of the event's tag.
+    // Returns false if it isn't one of ours.
+    bool post(const RNBO::MessageEvent& event, const char* tagName) noexcept;
+
+    bool hasPendingEvents() const noexcept      { return _anyDirty.load(std::memory_order_acquire); }
+
+    // Message thread. Returns an id for unsubscribe(), or -1 if there's no outport with that tag.
+    // Don't subscribe or unsubscribe from inside a callback.
+    int subscribe(const juce::String& tag, Callback callback);
+    void unsubscribe(int subscriptionId);
+
+    // Message thread. Calls the subscribers of every tag that received a message since the last drain.
+    void drain();
+
+private:
+    struct Slot
+    {
+        // producer only, cached the first time the tag is seen
+        RNBO::MessageTag messageTag = 0;
+        bool messageTagKnown = false;
+
+        // seqlock: odd while the producer writes
+        std::atomic<uint32_t> sequence { 0 };
+        std::atomic<int> type { Event::Bang };
+        std::atomic<int> numValues { 0 };
+        std::array<std::atomic<double>, maxListValues> values;
+
+        std::atomic<uint32_t> numPosted { 0 };
+        std::atomic<bool> dirty { false };
+    };
+
+    struct Subscription
+    {
+        int id;
+        int slot;
+        Callback callback;
+    };
+
+    int findSlot(RNBO::MessageTag messageTag, const char* tagName) noexcept;
+    Event readSlot(Slot& slot) const noexcept;
+
+    juce::StringArray               _tags;
+    std::unique_ptr<Slot[]>         _slots;
+    std::atomic<bool>               _anyDirty { false };
+
+    // message thread
+    std::vector<Subscription>       _subscriptions;
+    int                             _nextSubscriptionId = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (OutportEventBus)
+};
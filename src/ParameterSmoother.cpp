@@ -0,0 +1,237 @@
+#include "ParameterSmoother.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ParameterSmoother::~ParameterSmoother()
+{
+    collectRetiredBanks();
+    delete _pending.exchange(nullptr);
+    delete _active;
+}
+
+void ParameterSmoother::setSettings(const std::vector<Setting>& settings, RNBO::CoreObject& coreObject)
+{
+    const int numParameters = (int) coreObject.getNumParameters();
+
+    std::vector<Setting> smoothed;
+    for (const auto& setting : settings) {
+        if (setting.milliseconds > 0.0 && juce::isPositiveAndBelow(setting.index, numParameters))
+            smoothed.push_back(setting);
+    }
+
+    // exponential first, each curve is then one contiguous run for the vector operations
+    std::stable_sort(smoothed.begin(), smoothed.end(), [](const Setting& a, const Setting& b) {
+        return a.curve == Curve::exponential && b.curve != Curve::exponential;
+    });
+
+    auto bank = std::make_unique<Bank>();
+    bank->numSlots = (int) smoothed.size();
+    bank->slotByParameter.assign((size_t) numParameters, -1);
+
+    const size_t size = (size_t) juce::jmax(1, bank->numSlots);
+    bank->current.allocate(size, true);
+    bank->target.allocate(size, true);
+    bank->scratch.allocate(size, true);
+    bank->lastSent.allocate(size, true);
+    bank->coefficient.allocate(size, true);
+    bank->step.allocate(size, true);
+    bank->negativeStep.allocate(size, true);
+    bank->stepPending.allocate(size, true);
+
+    for (int slot = 0; slot < bank->numSlots; slot++) {
+        const Setting& setting = smoothed[(size_t) slot];
+        const float value = (float) coreObject.getParameterValue(setting.index);
+
+        bank->parameters.push_back(setting.index);
+        bank->milliseconds.push_back(setting.milliseconds);
+        bank->slotByParameter[(size_t) setting.index] = slot;
+        bank->current[slot] = bank->target[slot] = bank->lastSent[slot] = value;
+
+        if (setting.curve == Curve::exponential)
+            bank->numExponential++;
+    }
+
+    // the audio thread hands back at most one bank per bank we publish
+    collectRetiredBanks();
+    delete _pending.exchange(bank.release(), std::memory_order_acq_rel);
+}
+
+void ParameterSmoother::collectRetiredBanks()
+{
+    Bank* bank = nullptr;
+    while (_retired.pop(bank)) {
+        delete bank;
+    }
+}
+
+void ParameterSmoother::takePendingBank(RNBO::CoreObject& coreObject) noexcept
+{
+    Bank* next = _pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (next == nullptr)
+        return;
+
+    if (Bank* previous = _active) {
+        // ramps in progress carry on where they are, the message thread only saw the values sent so far
+        for (int slot = 0; slot < next->numSlots; slot++) {
+            const size_t parameter = (size_t) next->parameters[(size_t) slot];
+            const int previousSlot = parameter < previous->slotByParameter.size() ? previous->slotByParameter[parameter] : -1;
+            if (previousSlot < 0)
+                continue;
+
+            next->current[slot] = previous->current[previousSlot];
+            next->target[slot] = previous->target[previousSlot];
+            next->lastSent[slot] = previous->lastSent[previousSlot];
+
+            if (next->target[slot] != next->current[slot]) {
+                next->moving = true;
+                next->stepPending[slot] = slot >= next->numExponential;
+                next->anyStepPending = next->anyStepPending || next->stepPending[slot];
+            }
+        }
+
+        // no longer smoothed, so it goes straight to where it was heading
+        for (int slot = 0; slot < previous->numSlots; slot++) {
+            const RNBO::ParameterIndex parameter = previous->parameters[(size_t) slot];
+            if (next->slotByParameter[(size_t) parameter] < 0 && previous->target[slot] != previous->lastSent[slot])
+                coreObject.setParameterValue(parameter, previous->target[slot], coreObject.getCurrentTime());
+        }
+
+        const bool handedBack = _retired.push(previous);
+        jassert(handedBack);
+        ignoreUnused(handedBack);
+    }
+
+    _active = next;
+}
+
+bool ParameterSmoother::setTarget(RNBO::CoreObject& coreObject, RNBO::ParameterIndex index, RNBO::ParameterValue value,
+                                  bool overridesDirectChange) noexcept
+{
+    // nothing is smoothed until process() takes over the first bank, the caller sets the value directly
+    if (_active == nullptr || ! juce::isPositiveAndBelow(index, (RNBO::ParameterIndex) _active->slotByParameter.size()))
+        return false;
+
+    Bank& bank = *_active;
+    const int slot = bank.slotByParameter[(size_t) index];
+    if (slot < 0)
+        return false;
+
+    // an idle slot may be stale, the morph and restored state set the RNBO object directly
+    if (bank.current[slot] == bank.target[slot] && bank.lastSent[slot] == bank.current[slot])
+        bank.current[slot] = bank.lastSent[slot] = (float) coreObject.getParameterValue(index);
+
+    bank.target[slot] = (float) value;
+    bank.moving = true;
+
+    // never equal to the current value, so the first step sends it and undoes the direct change
+    if (overridesDirectChange)
+        bank.lastSent[slot] = std::numeric_limits<float>::quiet_NaN();
+
+    // the step depends on the sample rate, which only process() knows for sure
+    if (slot >= bank.numExponential) {
+        bank.stepPending[slot] = true;
+        bank.anyStepPending = true;
+    }
+
+    return true;
+}
+
+void ParameterSmoother::updateCoefficients(Bank& bank, double sampleRate) const
+{
+    bank.sampleRate = sampleRate;
+
+    for (int slot = 0; slot < bank.numExponential; slot++) {
+        // ln(100): 99% of the way after the set time
+        const double timeSamples = bank.milliseconds[(size_t) slot] * sampleRate / 1000.0;
+        bank.coefficient[slot] = (float) (1.0 - std::exp(-4.605 * controlInterval / juce::jmax(1.0, timeSamples)));
+    }
+
+    // ramps in progress cover what's left in their full time at the new rate
+    for (int slot = bank.numExponential; slot < bank.numSlots; slot++) {
+        if (bank.target[slot] != bank.current[slot]) {
+            bank.stepPending[slot] = true;
+            bank.anyStepPending = true;
+        }
+    }
+}
+
+void ParameterSmoother::updateLinearSteps(Bank& bank) const
+{
+    bank.anyStepPending = false;
+
+    for (int slot = bank.numExponential; slot < bank.numSlots; slot++) {
+        if (! bank.stepPending[slot])
+            continue;
+
+        bank.stepPending[slot] = false;
+
+        // a linear ramp covers the distance from where it is now in the full time
+        const double timeSamples = bank.milliseconds[(size_t) slot] * bank.sampleRate / 1000.0;
+        const float distance = std::abs(bank.target[slot] - bank.current[slot]);
+        const float step = timeSamples > controlInterval ? (float) (distance * controlInterval / timeSamples) : distance;
+
+        bank.step[slot] = step;
+        bank.negativeStep[slot] = -step;
+    }
+}
+
+void ParameterSmoother::process(RNBO::CoreObject& coreObject, int numSamples, double sampleRate)
+{
+    takePendingBank(coreObject);
+
+    if (_active == nullptr || numSamples <= 0 || sampleRate <= 0.0)
+        return;
+
+    // kept up to date while idle too, so the first target after a quiet spell ramps at the right speed
+    Bank& bank = *_active;
+    if (bank.sampleRate != sampleRate)
+        updateCoefficients(bank, sampleRate);
+
+    if (! bank.moving)
+        return;
+
+    if (bank.anyStepPending)
+        updateLinearSteps(bank);
+
+    const int numExponential = bank.numExponential;
+    const int numLinear = bank.numSlots - numExponential;
+    float* const linearCurrent = bank.current.get() + numExponential;
+    float* const linearScratch = bank.scratch.get() + numExponential;
+
+    const RNBO::MillisecondTime blockStart = coreObject.getCurrentTime();
+    const double millisecondsPerSample = 1000.0 / sampleRate;
+    bool moving = true;
+
+    for (int offset = 0; offset < numSamples && moving; offset += controlInterval) {
+        // exponential: current += (target - current) * coefficient
+        juce::FloatVectorOperations::subtract(bank.scratch.get(), bank.target.get(), bank.current.get(), numExponential);
+        juce::FloatVectorOperations::multiply(bank.scratch.get(), bank.coefficient.get(), numExponential);
+        juce::FloatVectorOperations::add(bank.current.get(), bank.scratch.get(), numExponential);
+
+        // linear: current += clamp(target - current, -step, step)
+        juce::FloatVectorOperations::subtract(linearScratch, bank.target.get() + numExponential, linearCurrent, numLinear);
+        juce::FloatVectorOperations::max(linearScratch, linearScratch, bank.negativeStep.get() + numExponential, numLinear);
+        juce::FloatVectorOperations::min(linearScratch, linearScratch, bank.step.get() + numExponential, numLinear);
+        juce::FloatVectorOperations::add(linearCurrent, linearScratch, numLinear);
+
+        const RNBO::MillisecondTime time = blockStart + offset * millisecondsPerSample;
+        moving = false;
+
+        for (int slot = 0; slot < bank.numSlots; slot++) {
+            // exponential ramps never quite arrive, snap them once the rest is inaudible
+            if (std::abs(bank.target[slot] - bank.current[slot]) <= 1.0e-6f * (1.0f + std::abs(bank.target[slot])))
+                bank.current[slot] = bank.target[slot];
+            else
+                moving = true;
+
+            if (bank.current[slot] != bank.lastSent[slot]) {
+                bank.lastSent[slot] = bank.current[slot];
+                coreObject.setParameterValue(bank.parameters[(size_t) slot], bank.current[slot], time);
+            }
+        }
+    }
+
+    bank.moving = moving;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include "LockFreeQueue.h"
+
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/*
+    Ramps parameter changes for the RNBO object, so the patch doesn't need a line~ per
+    parameter.
+
+    Each smoothed parameter has a time and a curve. A linear ramp covers the whole
+    change in that time. An exponential one gets 99% of the way there. New targets come
+    in on the audio thread through setTarget(). Every controlInterval samples, all
+    ramps advance together with a few vector operations, one pass per curve. Every
+    value that moved goes to the RNBO object as a timestamped parameter event.
+
+    Only values passed to setTarget() are smoothed. Something that has already set the
+    RNBO object directly, such as host automation through the adapter's parameters, can
+    pass overridesDirectChange so a ramp in progress carries on from where the smoother
+    had it. The morph still sets parameters directly.
+*/
+class ParameterSmoother
+{
+public:
+    static constexpr int controlInterval = 32;   // samples between ramp steps
+
+    enum class Curve { linear, exponential };
+
+    struct Setting
+    {
+        RNBO::ParameterIndex index;
+        double milliseconds;
+        Curve curve;
+    };
+
+    ParameterSmoother() = default;
+    ~ParameterSmoother();
+
+    // Message thread. Parameters not listed, or listed with a time of 0, aren't smoothed.
+    // Ramps in progress carry on towards their targets; a parameter that stops being
+    // smoothed mid-ramp jumps to its target.
+    void setSettings(const std::vector<Setting>& settings, RNBO::CoreObject& coreObject);
+
+    // Audio thread. Returns false if the parameter isn't smoothed, the caller sets it directly then.
+    // A parameter that isn't ramping starts from the RNBO object's value, so changes that bypassed
+    // the smoother (the morph, restored state) aren't undone. Pass overridesDirectChange if the
+    // value already reached the RNBO object directly this block; a ramp in progress then sends its
+    // own current value at the block start to undo the jump.
+    bool setTarget(RNBO::CoreObject& coreObject, RNBO::ParameterIndex index, RNBO::ParameterValue value,
+                   bool overridesDirectChange = false) noexcept;
+
+    // Audio thread, before the RNBO object processes the block
+    void process(RNBO::CoreObject& coreObject, int numSamples, double sampleRate);
+
+private:
+    // One slot per smoothed parameter, the exponential ones first so each curve is one contiguous run
+    struct Bank
+    {
+        int numSlots = 0;
+        int numExponential = 0;
+        std::vector<RNBO::ParameterIndex> parameters;   // slot -> parameter
+        std::vector<int> slotByParameter;               // parameter -> slot, -1 when not smoothed
+        std::vector<double> milliseconds;
+
+        juce::HeapBlock<float> current, target, scratch, lastSent;
+        juce::HeapBlock<float> coefficient;     // exponential: fraction of the distance per step
+        juce::HeapBlock<float> step;            // linear: largest move per step, worked out in process()
+        juce::HeapBlock<float> negativeStep;
+        juce::HeapBlock<bool> stepPending;      // linear: has a target whose step isn't worked out yet
+
+        double sampleRate = 0.0;                // what the coefficients are for, 0 before the first block
+        bool moving = false;
+        bool anyStepPending = false;
+    };
+
+    void takePendingBank(RNBO::CoreObject& coreObject) noexcept;
+    void updateCoefficients(Bank& bank, double sampleRate) const;
+    void updateLinearSteps(Bank& bank) const;
+    void collectRetiredBanks();
+
+    std::atomic<Bank*>      _pending { nullptr };
+    LockFreeQueue<Bank*, 8> _retired;
+
+    // audio thread
+    Bank*                   _active = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterSmoother)
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+/*
+    One "latest value" slot per parameter. Any thread can write a slot without
+    locking or allocating, and the reader drains all slots that changed since the
+    last drain in one pass. Several writes to the same slot in between coalesce
+    into the most recent value.
+*/
+class ParameterValueSlots
+{
+public:
+    // Not thread safe, call before any writer can see this object
+    void resize(int numSlots)
+    {
+        _numSlots = juce::jmax(0, numSlots);
+        _values.reset(new std::atomic<float>[(size_t) _numSlots]);
+        _dirty.reset(new std::atomic<bool>[(size_t) _numSlots]);
+
+        for (int i = 0; i < _numSlots; i++) {
+            _values[(size_t) i].store(0.0f, std::memory_order_relaxed);
+            _dirty[(size_t) i].store(false, std::memory_order_relaxed);
+        }
+        _anyDirty.store(false);
+    }
+
+    // Returns true if this write made the slots go from clean to dirty, so the caller can wake
+    // the reader once per batch of changes instead of once per change.
+    bool set(int index, float value) noexcept
+    {
+        if (! juce::isPositiveAndBelow(index, _numSlots))
+            return false;
+
+        _values[(size_t) index].store(value, std::memory_order_relaxed);
+        _dirty[(size_t) index].store(true, std::memory_order_release);
+        return ! _anyDirty.exchange(true, std::memory_order_acq_rel);
+    }
+
+    bool hasPendingValues() const noexcept  { return _anyDirty.load(std::memory_order_acquire); }
+
+    // Calls callback(index, value) for every slot written since the last drain
+    template <typename Callback>
+    void drain(Callback&& callback)
+    {
+        if (! _anyDirty.exchange(false, std::memory_order_acq_rel))
+            return;
+
+        for (int i = 0; i < _numSlots; i++) {
+            if (_dirty[(size_t) i].exchange(false, std::memory_order_acquire))
+                callback(i, _values[(size_t) i].load(std::memory_order_relaxed));
+        }
+    }
+
+private:
+    int                                     _numSlots = 0;
+    std::unique_ptr<std::atomic<float>[]>   _values;
+    std::unique_ptr<std::atomic<bool>[]>    _dirty;
+    std::atomic<bool>                       _anyDirty { false };
+};
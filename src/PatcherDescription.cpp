@@ -0,0 +1,92 @@
+#include "PatcherDescription.h"
+
+#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
+#include <rnbo_description.h>
+#endif
+
+PatcherDescription::Ptr PatcherDescription::getShared()
+{
+    // a function local static is initialized exactly once, even with several threads creating instances
+    static const Ptr shared = []
+    {
+        nlohmann::json description, presets;
+#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
+        description = RNBO::patcher_description;
+        presets = RNBO::patcher_presets;
+#endif
+        return Ptr(new PatcherDescription(std::move(description), std::move(presets)));
+    }();
+
+    return shared;
+}
+
+PatcherDescription::PatcherDescription(nlohmann::json description, nlohmann::json presets)
+    : _description(std::move(description))
+    , _presets(std::move(presets))
+{
+    if (! _description.is_object() || ! _description.contains("parameters"))
+        return;
+
+    const auto& parameters = _description["parameters"];
+    if (! parameters.is_array())
+        return;
+
+    _parameters.reserve(parameters.size());
+
+    for (const auto& entry : parameters) {
+        if (! entry.is_object())
+            continue;
+
+        Parameter parameter;
+        parameter.index = entry.value("index", (int) _parameters.size());
+        parameter.id = juce::String(entry.value("paramId", std::string()));
+        parameter.name = juce::String(entry.value("name", std::string()));
+        parameter.minimum = entry.value("minimum", 0.0);
+        parameter.maximum = entry.value("maximum", 1.0);
+        parameter.initialValue = entry.value("initialValue", 0.0);
+        parameter.steps = entry.value("steps", 0);
+        parameter.visible = entry.value("visible", true);
+
+        // meta is an object in newer exports, a JSON string in older ones
+        nlohmann::json meta = entry.value("meta", nlohmann::json());
+        if (meta.is_string())
+            meta = nlohmann::json::parse(meta.get<std::string>(), nullptr, false);
+
+        if (meta.is_object()) {
+            const auto smooth = meta.find("smooth");
+            if (smooth != meta.end() && smooth->is_number())
+                parameter.smoothingMs = juce::jmax(0.0, smooth->get<double>());
+
+            const auto curve = meta.find("curve");
+            parameter.exponentialSmoothing = curve != meta.end() && curve->is_string() && curve->get<std::string>() == "exp";
+        }
+
+        if (parameter.id.isNotEmpty())
+            _indexById.set(parameter.id, (int) _parameters.size());
+
+        _parameters.push_back(std::move(parameter));
+    }
+}
+
+RNBO::ParameterIndex PatcherDescription::getParameterIndex(const juce::String& id) const
+{
+    if (! _indexById.contains(id))
+        return -1;
+
+    return _parameters[(size_t) _indexById[id]].index;
+}
+
+RNBO::ParameterIndex PatcherDescription::findParameterIndex(const PatcherDescription* description,
+                                                            RNBO::CoreObject& coreObject,
+                                                            const juce::String& id)
+{
+    // the table describes the exported patcher, a hot reloaded one may have moved things around
+    if (description != nullptr) {
+        const RNBO::ParameterIndex index = description->getParameterIndex(id);
+        if (juce::isPositiveAndBelow(index, (RNBO::ParameterIndex) coreObject.getNumParameters())
+            && id == coreObject.getParameterId(index))
+            return index;
+    }
+
+    return coreObject.getParameterIndexForID(id.toRawUTF8());
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include <json/json.hpp>
+
+#include <vector>
+
+//==============================================================================
+/*
+    The exported patcher description and presets, built once per process and shared,
+    read-only, by every CustomAudioProcessor. Alongside the JSON it keeps a flat table
+    of the parameters and a hash map from parameter id to index. Our own code looks
+    parameters up there instead of walking the JSON or the RNBO object again for each
+    instance.
+
+    Without RNBO_INCLUDE_DESCRIPTION_FILE both JSON objects are null and the table is
+    empty; lookups then fall back to the RNBO object.
+*/
+class PatcherDescription : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<const PatcherDescription>;
+
+    struct Parameter
+    {
+        RNBO::ParameterIndex index = -1;
+        juce::String id;
+        juce::String name;
+        double minimum = 0.0;
+        double maximum = 1.0;
+        double initialValue = 0.0;
+        int steps = 0;
+        bool visible = true;
+
+        // from the parameter's meta, e.g. @meta {"smooth": 40, "curve": "exp"} on the param object
+        double smoothingMs = 0.0;
+        bool exponentialSmoothing = false;
+    };
+
+    // Thread safe, the first call builds the shared description
+    static Ptr getShared();
+
+    PatcherDescription(nlohmann::json description, nlohmann::json presets);
+
+    const nlohmann::json& getDescription() const    { return _description; }
+    const nlohmann::json& getPresets() const        { return _presets; }
+
+    int getNumParameters() const                    { return (int) _parameters.size(); }
+    const Parameter& getParameter(int i) const      { return _parameters[(size_t) i]; }
+
+    // -1 if the table doesn't know the id
+    RNBO::ParameterIndex getParameterIndex(const juce::String& id) const;
+
+    // The table when it has the id, the RNBO object's own lookup otherwise
+    static RNBO::ParameterIndex findParameterIndex(const PatcherDescription* description,
+                                                   RNBO::CoreObject& coreObject,
+                                                   const juce::String& id);
+
+private:
+    const nlohmann::json                    _description;
+    const nlohmann::json                    _presets;
+    std::vector<Parameter>                  _parameters;
+    juce::HashMap<juce::String, int>        _indexById;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PatcherDescription)
+};
@@ -0,0 +1,82 @@
+#include "PresetFile.h"
+
+static const char presetMagic[4] = { 'R', 'N', 'B', 'P' };
+static constexpr int headerSize = 7;
+
+juce::MemoryBlock PresetFile::encode(const std::vector<Parameter>& parameters, bool compress)
+{
+    juce::MemoryOutputStream payload;
+    payload.writeCompressedInt((int) parameters.size());
+
+    for (const auto& parameter : parameters) {
+        payload.writeString(parameter.id);
+        payload.writeDouble(parameter.value);
+    }
+
+    juce::MemoryOutputStream file;
+    file.write(presetMagic, sizeof(presetMagic));
+    file.writeShort((short) currentVersion);
+    file.writeByte((char) (compress ? compressedFlag : 0));
+
+    if (compress) {
+        juce::GZIPCompressorOutputStream compressor(file, 9);
+        compressor.write(payload.getData(), payload.getDataSize());
+        compressor.flush();
+    }
+    else {
+        file.write(payload.getData(), payload.getDataSize());
+    }
+
+    return file.getMemoryBlock();
+}
+
+bool PresetFile::hasPresetHeader(const juce::MemoryBlock& data)
+{
+    return data.getSize() >= (size_t) headerSize && memcmp(data.getData(), presetMagic, sizeof(presetMagic)) == 0;
+}
+
+bool PresetFile::decode(const juce::MemoryBlock& data, std::vector<Parameter>& parameters, juce::String& error)
+{
+    if (! hasPresetHeader(data)) {
+        error = "Not a preset file";
+        return false;
+    }
+
+    juce::MemoryInputStream header(data, false);
+    header.skipNextBytes(sizeof(presetMagic));
+    const int version = header.readShort();
+    const int flags = header.readByte();
+
+    if (version > currentVersion) {
+        error = "Preset was saved by a newer version (format " + juce::String(version) + ")";
+        return false;
+    }
+
+    juce::MemoryInputStream rawPayload(static_cast<const char*>(data.getData()) + headerSize, data.getSize() - (size_t) headerSize, false);
+    juce::GZIPDecompressorInputStream decompressor(rawPayload);
+    juce::InputStream& payload = (flags & compressedFlag) != 0 ? static_cast<juce::InputStream&>(decompressor)
+                                                               : static_cast<juce::InputStream&>(rawPayload);
+
+    const int numParameters = payload.readCompressedInt();
+    if (numParameters < 0 || numParameters > 1000000) {
+        error = "Preset is corrupt";
+        return false;
+    }
+
+    parameters.clear();
+    parameters.reserve((size_t) numParameters);
+
+    for (int i = 0; i < numParameters; i++) {
+        if (payload.isExhausted()) {
+            error = "Preset is truncated";
+            return false;
+        }
+
+        Parameter parameter;
+        parameter.id = payload.readString();
+        parameter.value = payload.readDouble();
+        parameters.push_back(std::move(parameter));
+    }
+
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <vector>
+
+//==============================================================================
+/*
+    Compact, versioned binary preset format used by the standalone app.
+
+        4 bytes     magic "RNBP"
+        2 bytes     format version, little endian
+        1 byte      flags, bit 0 set when the payload is gzip compressed
+        ...         payload
+
+    The payload is the number of parameters as a compressed int, followed by one
+    entry per parameter: its id as a null terminated UTF-8 string and its value as
+    a little endian double. Parameters are stored by id, not by index, so presets
+    survive a patcher that adds, removes or reorders parameters.
+
+    Encoding and decoding don't touch any processor and can run on any thread.
+*/
+class PresetFile
+{
+public:
+    struct Parameter
+    {
+        juce::String id;
+        double value = 0.0;
+    };
+
+    static constexpr int currentVersion = 1;
+
+    // Flags stored in the header
+    enum
+    {
+        compressedFlag = 1
+    };
+
+    static juce::MemoryBlock encode(const std::vector<Parameter>& parameters, bool compress);
+
+    // Returns false and fills error if the data isn't a preset this version can read
+    static bool decode(const juce::MemoryBlock& data, std::vector<Parameter>& parameters, juce::String& error);
+
+    // True if the data starts with our magic, anything else is treated as a legacy state blob
+    static bool hasPresetHeader(const juce::MemoryBlock& data);
+};
@@ -0,0 +1,131 @@
+#include "PresetMorpher.h"
+
+#include <limits>
+
+PresetMorpher::~PresetMorpher()
+{
+    collectRetiredTables();
+    delete _pending.exchange(nullptr);
+    delete _active;
+}
+
+void PresetMorpher::setSnapshots(const std::vector<Snapshot>& snapshots, RNBO::CoreObject& coreObject,
+                                 const PatcherDescription* description)
+{
+    const int numSnapshots = juce::jmin((int) snapshots.size(), maxSnapshots);
+    const int numParameters = (int) coreObject.getNumParameters();
+
+    // full matrix first, starting from the current values, then keep the columns that change
+    std::vector<float> full((size_t) (numSnapshots * numParameters));
+    for (int s = 0; s < numSnapshots; s++) {
+        for (int p = 0; p < numParameters; p++) {
+            full[(size_t) (s * numParameters + p)] = (float) coreObject.getParameterValue(p);
+        }
+
+        for (const auto& parameter : snapshots[(size_t) s]) {
+            const RNBO::ParameterIndex index = PatcherDescription::findParameterIndex(description, coreObject, parameter.id);
+            if (juce::isPositiveAndBelow(index, numParameters))
+                full[(size_t) (s * numParameters + index)] = (float) parameter.value;
+        }
+    }
+
+    auto table = std::make_unique<Table>();
+    table->numSnapshots = numSnapshots;
+
+    for (int p = 0; p < numParameters; p++) {
+        for (int s = 1; s < numSnapshots; s++) {
+            if (full[(size_t) (s * numParameters + p)] != full[(size_t) p]) {
+                table->parameters.push_back(p);
+                break;
+            }
+        }
+    }
+
+    const size_t numMorphed = table->parameters.size();
+    table->values.allocate(juce::jmax((size_t) 1, (size_t) numSnapshots * numMorphed), true);
+    table->scratch.allocate(juce::jmax((size_t) 1, numMorphed), true);
+    table->lastSent.allocate(juce::jmax((size_t) 1, numMorphed), false);
+
+    for (int s = 0; s < numSnapshots; s++) {
+        for (size_t m = 0; m < numMorphed; m++) {
+            table->values[(size_t) s * numMorphed + m] = full[(size_t) (s * numParameters + table->parameters[m])];
+        }
+    }
+
+    // NaN never compares equal, so every parameter is sent once when the table is picked up
+    for (size_t m = 0; m < numMorphed; m++) {
+        table->lastSent[m] = std::numeric_limits<float>::quiet_NaN();
+    }
+
+    // the audio thread hands back at most one table per table we publish
+    collectRetiredTables();
+    delete _pending.exchange(table.release(), std::memory_order_acq_rel);
+}
+
+void PresetMorpher::collectRetiredTables()
+{
+    Table* table = nullptr;
+    while (_retired.pop(table)) {
+        delete table;
+    }
+}
+
+void PresetMorpher::evaluate(const Table& table, float position) const
+{
+    const int numMorphed = table.getNumParameters();
+    const float x = juce::jlimit(0.0f, (float) (table.numSnapshots - 1), position * (float) (table.numSnapshots - 1));
+    const int lower = juce::jmin((int) x, table.numSnapshots - 2);
+    const float fraction = x - (float) lower;
+
+    juce::FloatVectorOperations::copyWithMultiply(table.scratch.get(), table.getRow(lower), 1.0f - fraction, numMorphed);
+    juce::FloatVectorOperations::addWithMultiply(table.scratch.get(), table.getRow(lower + 1), fraction, numMorphed);
+}
+
+void PresetMorpher::process(RNBO::CoreObject& coreObject, float position, int numSamples, double sampleRate)
+{
+    bool tableChanged = false;
+
+    if (Table* next = _pending.exchange(nullptr, std::memory_order_acq_rel)) {
+        if (_active != nullptr) {
+            const bool handedBack = _retired.push(_active);
+            jassert(handedBack);
+            ignoreUnused(handedBack);
+        }
+
+        _active = next;
+        tableChanged = true;
+    }
+
+    const float startPosition = tableChanged ? position : _lastPosition;
+    _lastPosition = position;
+
+    if (_active == nullptr || _active->numSnapshots < 2 || _active->parameters.empty() || numSamples <= 0)
+        return;
+
+    // nothing moved, the object already has these values and the user may be editing them
+    if (! tableChanged && startPosition == position)
+        return;
+
+    const int numPoints = juce::jmax(1, (numSamples + controlInterval - 1) / controlInterval);
+    const RNBO::MillisecondTime blockStart = coreObject.getCurrentTime();
+    const double millisecondsPerSample = 1000.0 / sampleRate;
+    const int numMorphed = _active->getNumParameters();
+
+    // each segment's value lands where the segment ends, so the last one is the block's
+    // position at the first sample of the next block
+    for (int point = 0; point < numPoints; point++) {
+        const int offset = (point + 1) * numSamples / numPoints;
+        const float pointPosition = startPosition + (position - startPosition) * (float) (point + 1) / (float) numPoints;
+
+        evaluate(*_active, pointPosition);
+
+        const RNBO::MillisecondTime time = blockStart + offset * millisecondsPerSample;
+        for (int m = 0; m < numMorphed; m++) {
+            const float value = _active->scratch[m];
+            if (value != _active->lastSent[m]) {
+                _active->lastSent[m] = value;
+                coreObject.setParameterValue(_active->parameters[(size_t) m], value, time);
+            }
+        }
+    }
+}
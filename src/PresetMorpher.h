@@ -0,0 +1,68 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include "LockFreeQueue.h"
+#include "PresetFile.h"
+#include "PatcherDescription.h"
+
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/*
+    Interpolates the RNBO object's parameters between two or more stored snapshots.
+    The morph position runs from 0 to 1 across the snapshots in order.
+
+    The snapshots are resolved to parameter indices on the message thread. The table
+    keeps only the parameters that actually differ between snapshots, laid out as one
+    contiguous row per snapshot, so the audio thread interpolates them all with a
+    couple of vector operations. Position changes within a block are ramped and fed
+    to the RNBO object as timestamped parameter events every controlInterval samples,
+    so a sweep is smooth however large the block is.
+*/
+class PresetMorpher
+{
+public:
+    static constexpr int maxSnapshots = 8;
+    static constexpr int controlInterval = 32;   // samples between interpolated parameter events
+
+    using Snapshot = std::vector<PresetFile::Parameter>;
+
+    PresetMorpher() = default;
+    ~PresetMorpher();
+
+    // Message thread. Parameters a snapshot doesn't mention keep the object's current value.
+    // Fewer than two snapshots turns morphing off.
+    void setSnapshots(const std::vector<Snapshot>& snapshots, RNBO::CoreObject& coreObject,
+                      const PatcherDescription* description = nullptr);
+
+    // Audio thread, before the RNBO object processes the block. position is the target
+    // for the end of this block, normalized.
+    void process(RNBO::CoreObject& coreObject, float position, int numSamples, double sampleRate);
+
+private:
+    struct Table
+    {
+        int numSnapshots = 0;
+        std::vector<RNBO::ParameterIndex> parameters;   // only the ones that differ between snapshots
+        juce::HeapBlock<float> values;                  // numSnapshots rows of parameters.size()
+        juce::HeapBlock<float> scratch;
+        juce::HeapBlock<float> lastSent;
+
+        int getNumParameters() const                { return (int) parameters.size(); }
+        const float* getRow(int snapshot) const     { return values.get() + (size_t) snapshot * parameters.size(); }
+    };
+
+    void evaluate(const Table& table, float position) const;
+    void collectRetiredTables();
+
+    std::atomic<Table*>     _pending { nullptr };
+    LockFreeQueue<Table*, 8> _retired;
+
+    // audio thread
+    Table*                  _active = nullptr;
+    float                   _lastPosition = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetMorpher)
+};
@@ -0,0 +1,147 @@
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+#include "OfflineRenderer.h"
+#include "RenderCheck.h"
+
+#include <iostream>
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout
+        << "Usage: RNBORender --output <file.wav> [options]\n"
+        << "       RNBORender --record <dir> | --check <dir> [check options]\n"
+        << "\n"
+        << "  --output, -o <file>      WAV file to write\n"
+        << "  --samplerate, -r <hz>    sample rate (default 48000)\n"
+        << "  --blocksize, -b <n>      processBlock size in samples (default 512)\n"
+        << "  --duration, -d <sec>     length of the render in seconds (default 10)\n"
+        << "  --params, -p <file>      parameter automation script, one \"<seconds> <id> <value>\" per line\n"
+        << "  --midi, -m <file>        standard MIDI file to play into the patch\n"
+        << "  --bits <n>               WAV bit depth, 16, 24 or 32 (default 24)\n"
+        << "\n"
+        << "  --record <dir>           render the regression scenarios and store them as the reference\n"
+        << "  --check <dir>            render the scenarios again and compare, exits with 1 on any failure\n"
+        << "  --tolerance <x>          largest allowed sample difference (default 0.0001)\n"
+        << "  --max-slowdown <x>       allowed cost increase per scenario, 0.25 is 25% (default 0.25)\n"
+        << "  --repetitions <n>        runs per scenario, the fastest is timed (default 3)\n"
+        << "  (--samplerate and --blocksize apply to --record, --check uses the recorded ones)\n"
+        << std::endl;
+}
+
+static int fail(const juce::String& message)
+{
+    std::cerr << "RNBORender: " << message << std::endl;
+    return 1;
+}
+
+static int runRenderCheck(const juce::ArgumentList& args, const OfflineRenderer::Settings& renderSettings)
+{
+    RenderCheck::Settings settings;
+    settings.sampleRate = renderSettings.sampleRate;
+    settings.blockSize = renderSettings.blockSize;
+    if (args.containsOption("--tolerance"))
+        settings.tolerance = args.getValueForOption("--tolerance").getDoubleValue();
+    if (args.containsOption("--max-slowdown"))
+        settings.maxSlowdown = args.getValueForOption("--max-slowdown").getDoubleValue();
+    if (args.containsOption("--repetitions"))
+        settings.repetitions = args.getValueForOption("--repetitions").getIntValue();
+
+    if (settings.tolerance < 0.0 || settings.maxSlowdown < 0.0 || settings.repetitions <= 0)
+        return fail("tolerance and max slowdown can't be negative, repetitions must be positive");
+
+    juce::String error;
+
+    if (args.containsOption("--record")) {
+        const auto directory = args.getFileForOption("--record");
+        if (! RenderCheck::record(directory, settings, error))
+            return fail(error);
+
+        std::cout << "Recorded " << RenderCheck::getScenarioNames().joinIntoString(", ") << " in "
+                  << directory.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    std::vector<RenderCheck::Result> results;
+    if (! RenderCheck::check(args.getFileForOption("--check"), settings, results, error))
+        return fail(error);
+
+    int numFailed = 0;
+    for (const auto& result : results) {
+        std::cout << (result.passed ? "PASS " : "FAIL ") << result.scenario.paddedRight(' ', 16)
+                  << "max diff " << result.maxDifference
+                  << "  " << result.nsPerSample << " ns/sample (baseline " << result.baselineNsPerSample << ")";
+        if (! result.passed)
+            std::cout << "\n     " << result.message;
+        std::cout << std::endl;
+
+        numFailed += result.passed ? 0 : 1;
+    }
+
+    std::cout << (results.size() - (size_t) numFailed) << " of " << results.size() << " scenarios passed" << std::endl;
+    return numFailed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    // the RNBO adapter posts async updates, so a message manager has to exist even without a window
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+
+    const bool checking = args.containsOption("--record") || args.containsOption("--check");
+
+    if (args.containsOption("--help|-h") || (! checking && ! args.containsOption("--output|-o"))) {
+        printUsage();
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    OfflineRenderer::Settings settings;
+    if (args.containsOption("--samplerate|-r"))
+        settings.sampleRate = args.getValueForOption("--samplerate|-r").getDoubleValue();
+    if (args.containsOption("--blocksize|-b"))
+        settings.blockSize = args.getValueForOption("--blocksize|-b").getIntValue();
+
+    double duration = 10.0;
+    if (args.containsOption("--duration|-d"))
+        duration = args.getValueForOption("--duration|-d").getDoubleValue();
+
+    int bits = 24;
+    if (args.containsOption("--bits"))
+        bits = args.getValueForOption("--bits").getIntValue();
+
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0 || duration <= 0.0)
+        return fail("sample rate, block size and duration must be positive");
+
+    if (checking)
+        return runRenderCheck(args, settings);
+
+    std::unique_ptr<CustomAudioProcessor> processor(CustomAudioProcessor::CreateDefault());
+    OfflineRenderer renderer(*processor, settings);
+
+    juce::String error;
+
+    if (args.containsOption("--params|-p")) {
+        if (! renderer.loadParameterScript(args.getFileForOption("--params|-p"), error))
+            return fail(error);
+    }
+
+    if (args.containsOption("--midi|-m")) {
+        if (! renderer.loadMidiFile(args.getFileForOption("--midi|-m"), error))
+            return fail(error);
+    }
+
+    const auto outputFile = args.getFileForOption("--output|-o");
+    const auto numSamples = juce::roundToInt64(duration * settings.sampleRate);
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    if (! renderer.renderToFile(outputFile, numSamples, bits, error))
+        return fail(error);
+    const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    std::cout << "Rendered " << duration << " s at " << settings.sampleRate << " Hz, block size " << settings.blockSize
+              << " to " << outputFile.getFullPathName() << "\n"
+              << "Wall time " << elapsed << " s, " << (elapsed > 0.0 ? duration / elapsed : 0.0) << "x realtime" << std::endl;
+
+    return 0;
+}
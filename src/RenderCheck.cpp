@@ -0,0 +1,339 @@
+#include "RenderCheck.h"
+#include "CustomAudioProcessor.h"
+#include "OfflineRenderer.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    enum class Scenario { defaults, kinkSweep, midiPhrase, presetRecall };
+
+    struct ScenarioInfo
+    {
+        Scenario scenario;
+        const char* name;
+        double seconds;
+    };
+
+    const ScenarioInfo scenarios[] = {
+        { Scenario::defaults,     "defaults",      2.0 },
+        { Scenario::kinkSweep,    "kink_sweep",    6.0 },
+        { Scenario::midiPhrase,   "midi_phrase",   3.0 },
+        { Scenario::presetRecall, "preset_recall", 4.0 },
+    };
+
+    const char* const kinkIds[] = { "kink1", "kink2", "kink3" };
+
+    struct PresetRecall
+    {
+        double seconds;
+        std::vector<PresetFile::Parameter> parameters;
+    };
+
+    std::vector<PresetRecall> getPresetRecalls()
+    {
+        return {
+            { 0.5, { { "kink1", 0.8 }, { "kink2", 0.2 }, { "kink3", 0.5 } } },
+            { 1.5, { { "kink1", 0.1 }, { "kink2", 0.9 }, { "kink3", 0.3 } } },
+            { 2.5, { { "kink1", 0.6 }, { "kink2", 0.6 }, { "kink3", 1.0 } } },
+            { 3.25, { { "kink1", 0.0 }, { "kink2", 0.0 }, { "kink3", 0.0 } } },
+        };
+    }
+
+    // Each kink moves from its minimum to its maximum in turn, the others hold where they are
+    bool addKinkSweep(OfflineRenderer& renderer, RNBO::CoreObject& coreObject, double seconds, juce::String& error)
+    {
+        const double sweepSeconds = seconds / (double) juce::numElementsInArray(kinkIds);
+        const double stepSeconds = 0.005;
+
+        for (int kink = 0; kink < juce::numElementsInArray(kinkIds); kink++) {
+            const RNBO::ParameterIndex index = coreObject.getParameterIndexForID(kinkIds[kink]);
+            if (index == -1) {
+                error = juce::String("The patch has no parameter \"") + kinkIds[kink] + "\"";
+                return false;
+            }
+
+            RNBO::ParameterInfo info;
+            coreObject.getParameterInfo(index, &info);
+            renderer.addParameterEvent(0.0, kinkIds[kink], info.min);
+
+            const double start = kink * sweepSeconds;
+            for (double t = 0.0; t <= sweepSeconds; t += stepSeconds) {
+                renderer.addParameterEvent(start + t, kinkIds[kink], info.min + (info.max - info.min) * t / sweepSeconds);
+            }
+        }
+
+        return true;
+    }
+
+    // An arpeggio with overlapping notes, a repeated note and a held chord at the end
+    juce::MidiMessageSequence getMidiPhrase()
+    {
+        juce::MidiMessageSequence sequence;
+        const int notes[] = { 48, 52, 55, 60, 60, 55, 52, 48 };
+
+        for (int i = 0; i < juce::numElementsInArray(notes); i++) {
+            const double onTime = i * 0.2;
+            sequence.addEvent(juce::MidiMessage::noteOn(1, notes[i], (juce::uint8) (64 + 8 * i)), onTime);
+            sequence.addEvent(juce::MidiMessage::noteOff(1, notes[i]), onTime + 0.3);
+        }
+
+        for (int note : { 48, 55, 64 }) {
+            sequence.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) 100), 1.8);
+            sequence.addEvent(juce::MidiMessage::noteOff(1, note), 2.6);
+        }
+
+        sequence.updateMatchedPairs();
+        return sequence;
+    }
+
+    bool renderScenario(const ScenarioInfo& info, double sampleRate, int blockSize,
+                        juce::AudioBuffer<float>& output, double& nsPerSample, juce::String& error)
+    {
+        std::unique_ptr<CustomAudioProcessor> processor(CustomAudioProcessor::CreateDefault());
+        OfflineRenderer renderer(*processor, { sampleRate, blockSize });
+
+        const int numSamples = juce::roundToInt(info.seconds * sampleRate);
+        const int numChannels = juce::jmax(1, renderer.getNumOutputChannels());
+        output.setSize(numChannels, numSamples);
+
+        std::vector<PresetRecall> recalls;
+
+        switch (info.scenario) {
+            case Scenario::defaults:
+                break;
+
+            case Scenario::kinkSweep:
+                if (! addKinkSweep(renderer, processor->getRnboObject(), info.seconds, error))
+                    return false;
+                break;
+
+            case Scenario::midiPhrase:
+                renderer.setMidiSequence(getMidiPhrase());
+                break;
+
+            case Scenario::presetRecall:
+                recalls = getPresetRecalls();
+                break;
+        }
+
+        size_t nextRecall = 0;
+        juce::int64 ticks = 0;
+
+        for (int position = 0; position < numSamples;) {
+            // presets are picked up at the start of a block, like they are from the app
+            while (nextRecall < recalls.size() && recalls[nextRecall].seconds * sampleRate < position + blockSize) {
+                processor->schedulePreset(recalls[nextRecall++].parameters);
+            }
+
+            const int rendered = renderer.processNextBlock();
+            ticks += renderer.getLastBlockTicks();
+
+            const int toCopy = juce::jmin(rendered, numSamples - position);
+            for (int channel = 0; channel < numChannels; channel++) {
+                output.copyFrom(channel, position, renderer.getOutput(), channel, 0, toCopy);
+            }
+
+            position += toCopy;
+        }
+
+        nsPerSample = juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / numSamples;
+        return true;
+    }
+
+    // The audio of the first run and the cost of the fastest
+    bool renderRepeatedly(const ScenarioInfo& info, double sampleRate, int blockSize, int repetitions,
+                          juce::AudioBuffer<float>& output, double& nsPerSample, juce::String& error)
+    {
+        nsPerSample = std::numeric_limits<double>::max();
+        juce::AudioBuffer<float> repeat;
+
+        for (int i = 0; i < juce::jmax(1, repetitions); i++) {
+            double runNsPerSample = 0.0;
+            if (! renderScenario(info, sampleRate, blockSize, i == 0 ? output : repeat, runNsPerSample, error))
+                return false;
+
+            nsPerSample = juce::jmin(nsPerSample, runNsPerSample);
+        }
+
+        return true;
+    }
+
+    juce::File getGoldenFile(const juce::File& directory, const ScenarioInfo& info)
+    {
+        return directory.getChildFile(juce::String(info.name) + ".wav");
+    }
+
+    juce::File getBaselineFile(const juce::File& directory)
+    {
+        return directory.getChildFile("baseline.json");
+    }
+
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate, juce::String& error)
+    {
+        file.deleteFile();
+
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        if (stream == nullptr || ! stream->openedOk()) {
+            error = "Couldn't write to " + file.getFullPathName();
+            return false;
+        }
+
+        // 32 bit float, so the comparison isn't limited by the file's resolution
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                            (unsigned int) buffer.getNumChannels(), 32, {}, 0));
+        if (writer == nullptr) {
+            error = "Couldn't create a WAV writer for " + file.getFullPathName();
+            return false;
+        }
+        stream.release(); // the writer owns the stream now
+
+        if (! writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples())) {
+            error = "Write error in " + file.getFullPathName();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer, juce::String& error)
+    {
+        if (! file.existsAsFile()) {
+            error = "Not recorded: " + file.getFullPathName();
+            return false;
+        }
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+        if (reader == nullptr) {
+            error = "Couldn't read " + file.getFullPathName();
+            return false;
+        }
+
+        buffer.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read(&buffer, 0, (int) reader->lengthInSamples, 0, true, true);
+        return true;
+    }
+
+    float getMaxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        float maxDifference = 0.0f;
+
+        for (int channel = 0; channel < a.getNumChannels(); channel++) {
+            const float* x = a.getReadPointer(channel);
+            const float* y = b.getReadPointer(channel);
+
+            for (int i = 0; i < a.getNumSamples(); i++) {
+                const float difference = std::abs(x[i] - y[i]);
+
+                // NaN compares false with everything, so it has to be caught by name
+                if (std::isnan(difference))
+                    return std::numeric_limits<float>::infinity();
+
+                maxDifference = juce::jmax(maxDifference, difference);
+            }
+        }
+
+        return maxDifference;
+    }
+}
+
+juce::StringArray RenderCheck::getScenarioNames()
+{
+    juce::StringArray names;
+    for (const auto& info : scenarios) {
+        names.add(info.name);
+    }
+    return names;
+}
+
+bool RenderCheck::record(const juce::File& directory, const Settings& settings, juce::String& error)
+{
+    if (! directory.createDirectory()) {
+        error = "Couldn't create " + directory.getFullPathName();
+        return false;
+    }
+
+    auto scenarioCosts = new juce::DynamicObject();
+
+    for (const auto& info : scenarios) {
+        juce::AudioBuffer<float> output;
+        double nsPerSample = 0.0;
+
+        if (! renderRepeatedly(info, settings.sampleRate, settings.blockSize, settings.repetitions, output, nsPerSample, error)
+            || ! writeWav(getGoldenFile(directory, info), output, settings.sampleRate, error))
+            return false;
+
+        auto cost = new juce::DynamicObject();
+        cost->setProperty("ns_per_sample", nsPerSample);
+        scenarioCosts->setProperty(info.name, juce::var(cost));
+    }
+
+    auto root = new juce::DynamicObject();
+    root->setProperty("sample_rate", settings.sampleRate);
+    root->setProperty("block_size", settings.blockSize);
+    root->setProperty("scenarios", juce::var(scenarioCosts));
+
+    if (! getBaselineFile(directory).replaceWithText(juce::JSON::toString(juce::var(root)))) {
+        error = "Couldn't write " + getBaselineFile(directory).getFullPathName();
+        return false;
+    }
+
+    return true;
+}
+
+bool RenderCheck::check(const juce::File& directory, const Settings& settings, std::vector<Result>& results,
+                        juce::String& error)
+{
+    const juce::var baseline = juce::JSON::parse(getBaselineFile(directory));
+    if (! baseline.isObject()) {
+        error = "No recording in " + directory.getFullPathName() + ", run with --record first";
+        return false;
+    }
+
+    // the golden files are only comparable at the settings they were made with
+    const double sampleRate = baseline.getProperty("sample_rate", 0.0);
+    const int blockSize = baseline.getProperty("block_size", 0);
+    if (sampleRate <= 0.0 || blockSize <= 0) {
+        error = getBaselineFile(directory).getFullPathName() + " has no valid sample rate and block size";
+        return false;
+    }
+
+    results.clear();
+
+    for (const auto& info : scenarios) {
+        Result result;
+        result.scenario = info.name;
+        result.baselineNsPerSample = baseline["scenarios"][info.name].getProperty("ns_per_sample", 0.0);
+
+        juce::AudioBuffer<float> golden, output;
+        juce::String scenarioError;
+
+        if (! readWav(getGoldenFile(directory, info), golden, scenarioError)
+            || ! renderRepeatedly(info, sampleRate, blockSize, settings.repetitions, output, result.nsPerSample, scenarioError)) {
+            result.message = scenarioError;
+        }
+        else if (golden.getNumChannels() != output.getNumChannels() || golden.getNumSamples() != output.getNumSamples()) {
+            result.message = "recorded " + juce::String(golden.getNumChannels()) + " channels of " + juce::String(golden.getNumSamples())
+                           + " samples, rendered " + juce::String(output.getNumChannels()) + " of " + juce::String(output.getNumSamples());
+        }
+        else {
+            result.maxDifference = getMaxDifference(golden, output);
+
+            if (result.maxDifference > settings.tolerance)
+                result.message = "output differs by up to " + juce::String(result.maxDifference, 6)
+                               + ", tolerance " + juce::String(settings.tolerance, 6);
+            else if (result.baselineNsPerSample > 0.0 && result.nsPerSample > result.baselineNsPerSample * (1.0 + settings.maxSlowdown))
+                result.message = juce::String(result.nsPerSample, 1) + " ns per sample, baseline "
+                               + juce::String(result.baselineNsPerSample, 1) + " allows up to "
+                               + juce::String(result.baselineNsPerSample * (1.0 + settings.maxSlowdown), 1);
+        }
+
+        result.passed = result.message.isEmpty();
+        results.push_back(result);
+    }
+
+    return true;
+}
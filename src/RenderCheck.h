@@ -0,0 +1,55 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <vector>
+
+//==============================================================================
+/*
+    Golden-render regression check for the exported patch.
+
+    A fixed set of scenarios is rendered offline: defaults, a sweep of each kink
+    parameter, a MIDI phrase and a series of preset recalls. record() writes each
+    render as a float WAV into a directory, together with baseline.json. That file
+    holds the sample rate, the block size and each scenario's processing cost in ns
+    per sample. check() renders the same scenarios with those settings and compares
+    them with the recorded files, sample by sample, within a tolerance. A scenario
+    also fails if it got slower than its baseline by more than the allowed
+    fraction.
+
+    Each scenario runs several times on a fresh processor. The audio comes from the
+    first run and the cost is the fastest run, which keeps the timing stable on a
+    busy machine. Timing baselines only compare on the machine that recorded them.
+*/
+class RenderCheck
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 48000.0;    // record() only, check() uses the recorded settings
+        int blockSize = 256;
+        double tolerance = 1.0e-4;      // largest allowed difference of any sample
+        double maxSlowdown = 0.25;      // 0.25 fails anything more than 25% slower than its baseline
+        int repetitions = 3;
+    };
+
+    struct Result
+    {
+        juce::String scenario;
+        bool passed = false;
+        float maxDifference = 0.0f;
+        double nsPerSample = 0.0;
+        double baselineNsPerSample = 0.0;
+        juce::String message;           // why it failed, empty if it passed
+    };
+
+    static juce::StringArray getScenarioNames();
+
+    // Renders every scenario into directory, replacing what was recorded there
+    static bool record(const juce::File& directory, const Settings& settings, juce::String& error);
+
+    // Renders every scenario and compares it with the recording in directory. Returns false
+    // and fills error only if the check couldn't run; failed scenarios are in results.
+    static bool check(const juce::File& directory, const Settings& settings, std::vector<Result>& results,
+                      juce::String& error);
+};
@@ -0,0 +1,195 @@
+#include "SharedBinaryData.h"
+
+#include <map>
+
+#ifdef RNBO_BINARY_DATA_STORAGE_NAME
+extern RNBO::BinaryDataImpl::Storage RNBO_BINARY_DATA_STORAGE_NAME;
+#endif
+
+const RNBO::BinaryData& SharedBinaryData::getEmbedded()
+{
+    // built on first use, after the storage itself has been initialized
+#ifdef RNBO_BINARY_DATA_STORAGE_NAME
+    static RNBO::BinaryDataImpl shared(RNBO_BINARY_DATA_STORAGE_NAME);
+#else
+    static RNBO::BinaryDataImpl::Storage emptyStorage;
+    static RNBO::BinaryDataImpl shared(emptyStorage);
+#endif
+    return shared;
+}
+
+//==============================================================================
+static uint32_t readLittleEndian32(const uint8_t* p)    { return juce::ByteOrder::littleEndianInt(p); }
+static uint16_t readLittleEndian16(const uint8_t* p)    { return juce::ByteOrder::littleEndianShort(p); }
+
+bool SharedBinaryData::Sample::mapFloatWav(const juce::File& file)
+{
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto* bytes = static_cast<const uint8_t*>(mapping->getData());
+    const size_t size = mapping->getSize();
+
+    if (bytes == nullptr || size < 12 || memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0)
+        return false;
+
+    int numChannels = 0, bitsPerSample = 0;
+    uint32_t sampleRate = 0;
+    bool isFloat = false;
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+
+    // walk the chunks, each one padded to an even size
+    for (size_t offset = 12; offset + 8 <= size;) {
+        const uint8_t* chunk = bytes + offset;
+        const size_t chunkSize = readLittleEndian32(chunk + 4);
+        const uint8_t* body = chunk + 8;
+        const size_t available = juce::jmin(chunkSize, size - offset - 8);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            const int formatTag = readLittleEndian16(body);
+            numChannels = readLittleEndian16(body + 2);
+            sampleRate = readLittleEndian32(body + 4);
+            bitsPerSample = readLittleEndian16(body + 14);
+
+            // WAVE_FORMAT_IEEE_FLOAT, or WAVE_FORMAT_EXTENSIBLE with a float sub format
+            isFloat = formatTag == 3 || (formatTag == 0xfffe && available >= 26 && readLittleEndian16(body + 24) == 3);
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            data = body;
+            dataSize = available;
+            break;
+        }
+
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    // RNBO reads the frames as floats straight from this memory
+    if (! isFloat || bitsPerSample != 32 || numChannels <= 0 || data == nullptr
+        || (reinterpret_cast<uintptr_t>(data) % alignof(float)) != 0)
+        return false;
+
+    _mapping = std::move(mapping);
+    _data = reinterpret_cast<const float*>(data);
+    _sizeInBytes = dataSize - dataSize % ((size_t) numChannels * sizeof(float));
+    _numChannels = numChannels;
+    _sampleRate = (double) sampleRate;
+    return true;
+}
+
+bool SharedBinaryData::Sample::decode(const juce::File& file, juce::String& error)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr) {
+        error = "Couldn't read " + file.getFullPathName();
+        return false;
+    }
+
+    const int numChannels = (int) reader->numChannels;
+    const int numFrames = (int) reader->lengthInSamples;
+
+    juce::AudioBuffer<float> buffer(numChannels, numFrames);
+    reader->read(&buffer, 0, numFrames, 0, true, true);
+
+    _decoded.allocate((size_t) numChannels * (size_t) numFrames, false);
+    for (int channel = 0; channel < numChannels; channel++) {
+        const float* source = buffer.getReadPointer(channel);
+        for (int frame = 0; frame < numFrames; frame++) {
+            _decoded[(size_t) frame * (size_t) numChannels + (size_t) channel] = source[frame];
+        }
+    }
+
+    _data = _decoded.get();
+    _sizeInBytes = (size_t) numChannels * (size_t) numFrames * sizeof(float);
+    _numChannels = numChannels;
+    _sampleRate = reader->sampleRate;
+    return true;
+}
+
+SharedBinaryData::Sample::Ptr SharedBinaryData::getSample(const juce::File& file, juce::String& error)
+{
+    static juce::CriticalSection lock;
+    static std::map<juce::String, Sample::Ptr> cache;
+
+    const juce::ScopedLock sl(lock);
+
+    auto found = cache.find(file.getFullPathName());
+    if (found != cache.end())
+        return found->second;
+
+    if (! file.existsAsFile()) {
+        error = "No such file: " + file.getFullPathName();
+        return nullptr;
+    }
+
+    Sample::Ptr sample(new Sample());
+    if (! sample->mapFloatWav(file) && ! sample->decode(file, error))
+        return nullptr;
+
+    cache[file.getFullPathName()] = sample;
+    return sample;
+}
+
+const std::vector<SharedBinaryData::MappedDataref>& SharedBinaryData::getMappedDatarefs()
+{
+    static const std::vector<MappedDataref> datarefs = []
+    {
+        std::vector<MappedDataref> result;
+
+#ifdef RNBO_MAPPED_DATAREFS_FILE
+        const juce::File listFile(RNBO_MAPPED_DATAREFS_FILE);
+        const juce::var list = juce::JSON::parse(listFile);
+
+        if (auto entries = list.getArray()) {
+            for (const auto& entry : *entries) {
+                const juce::String id = entry["id"].toString();
+                const juce::String path = entry["file"].toString();
+
+                // remote dependencies have a "url" instead, those aren't ours to load
+                if (id.isEmpty() || path.isEmpty())
+                    continue;
+
+                MappedDataref dataref;
+                dataref.id = id;
+                dataref.file = listFile.getParentDirectory().getChildFile(path);
+                dataref.writable = (bool) entry.getProperty("writable", false);
+                dataref.stream = (bool) entry.getProperty("stream", false);
+                dataref.ringSeconds = (double) entry.getProperty("seconds", dataref.ringSeconds);
+                dataref.loop = (bool) entry.getProperty("loop", dataref.loop);
+                dataref.positionTag = entry.getProperty("position", id + "_position").toString();
+                result.push_back(dataref);
+            }
+        }
+        else {
+            reportError("RNBO_MAPPED_DATAREFS_FILE isn't a JSON array: " + listFile.getFullPathName());
+        }
+#endif
+
+        return result;
+    }();
+
+    return datarefs;
+}
+
+void SharedBinaryData::reportError(const juce::String& message)
+{
+    static juce::CriticalSection lock;
+    static juce::StringArray reported;
+
+    {
+        const juce::ScopedLock sl(lock);
+        if (reported.contains(message))
+            return;
+        reported.add(message);
+    }
+
+    juce::Logger::writeToLog(message);
+
+    // every instance fails the same way, one alert per problem is enough
+    if (juce::JUCEApplicationBase::isStandaloneApp() || juce::PluginHostType::getPluginLoadedAs() != juce::AudioProcessor::wrapperType_Undefined) {
+        juce::MessageManager::callAsync([message] {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Sample data", message);
+        });
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include "RNBO_BinaryData.h"
+
+#include <vector>
+
+//==============================================================================
+/*
+    Datarefs shared by every processor instance in the process.
+
+    getEmbedded() wraps the binary data compiled into the plugin once, instead of each
+    instance copying the whole storage.
+
+    Large sample files can be memory-mapped from disk instead of embedded. List them in
+    the JSON file named by the RNBO_MAPPED_DATAREFS_FILE CMake option, using the same
+    layout as RNBO's dependencies.json: [ { "id": "drone", "file": "media/drone.wav" } ].
+    Relative paths are resolved against the JSON file's folder. A 32-bit float WAV is
+    mapped as it is, since its data chunk is already the interleaved float layout RNBO
+    buffers use. Any other format is decoded into memory once per process. Either way,
+    all instances that load the same file share one copy.
+
+    Mapped files are read-only. A dataref the patch writes into (poke~, record~ and the
+    like) must be marked "writable": true. Each instance then gets its own copy of the
+    file's frames, so its writes don't fault and don't leak into other instances.
+
+    Recordings too long to keep around whole can be streamed instead. Add "stream": true
+    to the entry, and the dataref becomes a ring buffer that's refilled from disk as the
+    patch plays through it (see StreamingDataref). Optional keys are "seconds" (the ring
+    length, 10 by default), "loop" (true by default) and "position" (the parameter or
+    outport the patch reports its position to, "<id>_position" by default).
+*/
+class SharedBinaryData
+{
+public:
+    // The embedded datarefs, or an empty set if the export has none
+    static const RNBO::BinaryData& getEmbedded();
+
+    //==============================================================================
+    class Sample : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Sample>;
+
+        // Interleaved 32-bit float frames, read-only
+        const float* getData() const        { return _data; }
+        size_t getSizeInBytes() const       { return _sizeInBytes; }
+        int getNumChannels() const          { return _numChannels; }
+        double getSampleRate() const        { return _sampleRate; }
+        bool isMemoryMapped() const         { return _mapping != nullptr; }
+
+    private:
+        friend class SharedBinaryData;
+        Sample() = default;
+
+        bool mapFloatWav(const juce::File& file);
+        bool decode(const juce::File& file, juce::String& error);
+
+        std::unique_ptr<juce::MemoryMappedFile>     _mapping;
+        juce::HeapBlock<float>                      _decoded;
+        const float*                                _data = nullptr;
+        size_t                                      _sizeInBytes = 0;
+        int                                         _numChannels = 0;
+        double                                      _sampleRate = 0.0;
+    };
+
+    // Thread safe. Opens the file the first time it's asked for and returns the same
+    // sample to every later caller. Returns null and fills error if it can't be read.
+    static Sample::Ptr getSample(const juce::File& file, juce::String& error);
+
+    //==============================================================================
+    struct MappedDataref
+    {
+        juce::String id;
+        juce::File file;
+
+        // the patch writes into it, so every instance needs a private copy
+        bool writable = false;
+
+        // streamed through a ring instead of mapped
+        bool stream = false;
+        double ringSeconds = 10.0;
+        bool loop = true;
+        juce::String positionTag;
+    };
+
+    // The entries of RNBO_MAPPED_DATAREFS_FILE, read once. Empty without the option.
+    static const std::vector<MappedDataref>& getMappedDatarefs();
+
+    // Any thread. Writes a dataref problem to the juce::Logger, which release builds keep,
+    // and shows it once per process in an alert window when there's a GUI to show it in.
+    static void reportError(const juce::String& message);
+};
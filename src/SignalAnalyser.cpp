@@ -0,0 +1,123 @@
+#include "SignalAnalyser.h"
+
+#include <algorithm>
+#include <cmath>
+
+SignalAnalyser::SignalAnalyser(AudioTap& tap, std::function<void()> onNewFrame)
+  : _tap(tap)
+  , _onNewFrame(std::move(onNewFrame))
+{
+    _tap.addReader();
+    _thread->addTimeSliceClient(this);
+}
+
+SignalAnalyser::~SignalAnalyser()
+{
+    // waits for a slice in progress
+    _thread->removeTimeSliceClient(this);
+    _tap.removeReader();
+}
+
+bool SignalAnalyser::getLatestFrame(Frame& frame)
+{
+    const juce::SpinLock::ScopedLockType lock(_frameLock);
+    if (_published.number == frame.number)
+        return false;
+
+    frame = _published;
+    return true;
+}
+
+int SignalAnalyser::useTimeSlice()
+{
+    // nothing new since the last frame, e.g. the device stopped: the picture can't change
+    const uint64_t written = _tap.getNumWritten();
+    if (written == _lastWritten)
+        return frameIntervalMs;
+
+    const double sampleRate = _tap.getSampleRate();
+    if (sampleRate <= 0.0 || ! _tap.readLatest(_samples.data(), fftSize))
+        return frameIntervalMs;
+
+    _lastWritten = written;
+    updateScope();
+    updateSpectrum(sampleRate);
+
+    // silence, once the spectrum has fallen all the way, gives the same frame over and over;
+    // only this thread writes _published, so it can compare without the lock
+    if (_working.number > 0 && _working.scope == _published.scope && _working.spectrum == _published.spectrum)
+        return frameIntervalMs;
+
+    _working.number++;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(_frameLock);
+        _published = _working;
+    }
+
+    _publishedNumber.store(_working.number, std::memory_order_release);
+
+    if (_onNewFrame)
+        _onNewFrame();
+
+    return frameIntervalMs;
+}
+
+void SignalAnalyser::updateScope()
+{
+    // the latest rising zero crossing that still leaves a full window after it, so a
+    // steady tone stands still on screen; free running if there isn't one
+    int trigger = fftSize - scopeSamples;
+    for (int i = fftSize - scopeSamples; i > 0; i--) {
+        if (_samples[(size_t) i - 1] < 0.0f && _samples[(size_t) i] >= 0.0f) {
+            trigger = i;
+            break;
+        }
+    }
+
+    constexpr int samplesPerPoint = scopeSamples / numScopePoints;
+
+    for (int point = 0; point < numScopePoints; point++) {
+        const float* group = _samples.data() + trigger + point * samplesPerPoint;
+
+        float peak = group[0];
+        for (int i = 1; i < samplesPerPoint; i++) {
+            if (std::abs(group[i]) > std::abs(peak))
+                peak = group[i];
+        }
+
+        _working.scope[(size_t) point] = juce::jlimit(-1.0f, 1.0f, peak);
+    }
+}
+
+void SignalAnalyser::updateSpectrum(double sampleRate)
+{
+    std::copy(_samples.begin(), _samples.end(), _fftData.begin());
+    _window.multiplyWithWindowingTable(_fftData.data(), (size_t) fftSize);
+    _fft.performFrequencyOnlyForwardTransform(_fftData.data());
+
+    // a full scale sine reads 0 dB: half the bin energy is in the mirror image, and the Hann window halves the amplitude
+    const float magnitudeScale = 4.0f / (float) fftSize;
+    const double nyquist = sampleRate / 2.0;
+    const double lowest = 20.0;
+    const float fallPerFrame = 0.02f;
+
+    for (int band = 0; band < numSpectrumBands; band++) {
+        const double from = lowest * std::pow(nyquist / lowest, (double) band / numSpectrumBands);
+        const double to = lowest * std::pow(nyquist / lowest, (double) (band + 1) / numSpectrumBands);
+
+        const int firstBin = juce::jlimit(1, fftSize / 2 - 1, (int) (from / sampleRate * fftSize));
+        const int lastBin = juce::jlimit(firstBin, fftSize / 2 - 1, (int) (to / sampleRate * fftSize));
+
+        float magnitude = 0.0f;
+        for (int bin = firstBin; bin <= lastBin; bin++) {
+            magnitude = juce::jmax(magnitude, _fftData[(size_t) bin]);
+        }
+
+        const float decibels = juce::Decibels::gainToDecibels(magnitude * magnitudeScale, -90.0f);
+        const float level = juce::jmap(decibels, -90.0f, 0.0f, 0.0f, 1.0f);
+
+        float& shown = _working.spectrum[(size_t) band];
+        shown = juce::jlimit(0.0f, 1.0f, juce::jmax(level, shown - fallPerFrame));
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "AudioTap.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+
+//==============================================================================
+/*
+    Turns an AudioTap into display-ready scope and spectrum points on a background
+    thread, about 30 times a second.
+
+    The scope is a triggered window of the latest output, decimated to one point per
+    few samples and keeping each group's peak, so single-cycle spikes still show. The
+    spectrum is a Hann-windowed FFT, collected into log-spaced bands in dB. Each band
+    falls back slowly, like a meter, instead of flickering from frame to frame.
+
+    The message thread picks up the newest frame with getLatestFrame() and only
+    draws it. A frame is only published when the tap has new samples and the picture
+    changed, so a silent or stopped output settles once the spectrum has fallen, and
+    the display can stop animating. onNewFrame is called from the analyser thread
+    after each publish, to wake it again. The tap records only while an analyser exists.
+*/
+class SignalAnalyser : private juce::TimeSliceClient
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int scopeSamples = 1024;
+    static constexpr int numScopePoints = 256;
+    static constexpr int numSpectrumBands = 96;
+
+    struct Frame
+    {
+        uint64_t number = 0;
+        std::array<float, numScopePoints> scope {};         // -1 to 1
+        std::array<float, numSpectrumBands> spectrum {};    // 0 (-90 dB) to 1 (0 dB), 20 Hz up to Nyquist
+    };
+
+    SignalAnalyser(AudioTap& tap, std::function<void()> onNewFrame);
+    ~SignalAnalyser() override;
+
+    // Message thread. Copies the newest frame into frame, false if it has already seen it.
+    bool getLatestFrame(Frame& frame);
+
+    // Any thread. Whether there's a frame newer than the one numbered frameNumber.
+    bool hasFrameAfter(uint64_t frameNumber) const noexcept { return _publishedNumber.load(std::memory_order_acquire) != frameNumber; }
+
+private:
+    struct AnalyserThread : public juce::TimeSliceThread
+    {
+        AnalyserThread() : juce::TimeSliceThread("RNBO signal analyser")  { startThread(3); }
+        ~AnalyserThread() override                                          { stopThread(2000); }
+    };
+
+    static constexpr int frameIntervalMs = 33;
+
+    int useTimeSlice() override;
+    void updateScope();
+    void updateSpectrum(double sampleRate);
+
+    AudioTap&                               _tap;
+    const std::function<void()>             _onNewFrame;
+    juce::SharedResourcePointer<AnalyserThread> _thread;
+
+    // analyser thread
+    juce::dsp::FFT                          _fft { fftOrder };
+    juce::dsp::WindowingFunction<float>     _window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann };
+    std::array<float, fftSize>              _samples {};
+    std::array<float, 2 * fftSize>          _fftData {};
+    Frame                                   _working;
+    uint64_t                                _lastWritten = 0;
+
+    // the analyser thread and the message thread only, the audio thread never touches it
+    juce::SpinLock                          _frameLock;
+    Frame                                   _published;
+    std::atomic<uint64_t>                   _publishedNumber { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SignalAnalyser)
+};
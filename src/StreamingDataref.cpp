@@ -0,0 +1,113 @@
+#include "StreamingDataref.h"
+
+std::unique_ptr<StreamingDataref> StreamingDataref::open(const juce::File& file, double ringSeconds, bool loop,
+                                                         juce::String& error)
+{
+    if (! file.existsAsFile()) {
+        error = "No such file: " + file.getFullPathName();
+        return nullptr;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->numChannels == 0 || reader->lengthInSamples <= 0) {
+        error = "Couldn't read " + file.getFullPathName();
+        return nullptr;
+    }
+
+    std::unique_ptr<StreamingDataref> stream(new StreamingDataref());
+    stream->_numChannels = (int) reader->numChannels;
+    stream->_sampleRate = reader->sampleRate;
+    stream->_fileFrames = reader->lengthInSamples;
+    stream->_loop = loop;
+    stream->_reader = std::move(reader);
+
+    // a few chunks at least, so there's always room to read ahead of the guard
+    stream->_ringFrames = juce::jmax(4 * chunkFrames, (int) (ringSeconds * stream->_sampleRate));
+    stream->_guardFrames = stream->_ringFrames / 4;
+    stream->_ring.allocate((size_t) stream->_ringFrames * (size_t) stream->_numChannels, true);
+    stream->_readBuffer.setSize(stream->_numChannels, chunkFrames);
+
+    // just the start, the prefetch thread does the rest
+    stream->fillAhead(chunkFrames);
+    stream->_thread->addTimeSliceClient(stream.get());
+    return stream;
+}
+
+StreamingDataref::~StreamingDataref()
+{
+    // waits for a slice in progress
+    _thread->removeTimeSliceClient(this);
+}
+
+void StreamingDataref::setPlayPosition(juce::int64 streamFrame) noexcept
+{
+    if (streamFrame < _filledStart.load(std::memory_order_acquire) || streamFrame >= _filledEnd.load(std::memory_order_acquire))
+        _underruns.fetch_add(1, std::memory_order_relaxed);
+
+    _playFrame.store(streamFrame, std::memory_order_release);
+}
+
+int StreamingDataref::useTimeSlice()
+{
+    const int framesRead = fillAhead(chunkFrames);
+
+    // keep going while there's a backlog, otherwise check back well within the guard time
+    return framesRead == chunkFrames ? 0 : 10;
+}
+
+int StreamingDataref::fillAhead(int maxFrames)
+{
+    const juce::int64 play = _playFrame.load(std::memory_order_acquire);
+    juce::int64 start = _filledStart.load(std::memory_order_relaxed);
+    juce::int64 end = _filledEnd.load(std::memory_order_relaxed);
+
+    // the patch jumped somewhere the ring doesn't hold, start over from there
+    if (play < start || play > end) {
+        start = end = play;
+        _filledEnd.store(end, std::memory_order_release);
+        _filledStart.store(start, std::memory_order_release);
+    }
+
+    // never write over the guard behind the play position, the patch may still be reading it
+    const juce::int64 limit = play - _guardFrames + _ringFrames;
+    const int numFrames = (int) juce::jmin((juce::int64) maxFrames, limit - end);
+    if (numFrames <= 0)
+        return 0;
+
+    // the frames about to be overwritten leave the valid range before they change
+    _filledStart.store(juce::jmax(start, end + numFrames - _ringFrames), std::memory_order_release);
+    readFrames(end, numFrames);
+    _filledEnd.store(end + numFrames, std::memory_order_release);
+
+    return numFrames;
+}
+
+void StreamingDataref::readFrames(juce::int64 streamFrame, int numFrames)
+{
+    for (int done = 0; done < numFrames;) {
+        const juce::int64 frame = streamFrame + done;
+        const int ringIndex = (int) (frame % _ringFrames);
+        const juce::int64 fileFrame = _loop ? frame % _fileFrames : frame;
+
+        // stop at the ring's wrap, and at the file's end when looping
+        int span = juce::jmin(numFrames - done, _ringFrames - ringIndex);
+        if (_loop)
+            span = (int) juce::jmin((juce::int64) span, _fileFrames - fileFrame);
+
+        // the reader fills anything past the end of the file with silence
+        _reader->read(&_readBuffer, 0, span, fileFrame, true, true);
+
+        float* destination = _ring.get() + (size_t) ringIndex * (size_t) _numChannels;
+        for (int channel = 0; channel < _numChannels; channel++) {
+            const float* source = _readBuffer.getReadPointer(channel);
+            for (int i = 0; i < span; i++) {
+                destination[(size_t) i * (size_t) _numChannels + (size_t) channel] = source[i];
+            }
+        }
+
+        done += span;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <atomic>
+
+//==============================================================================
+/*
+    A dataref whose contents stream from an audio file on disk instead of being loaded
+    up front. RNBO gets a fixed-size ring of interleaved float frames as the buffer.
+    A shared background thread keeps the ring filled ahead of the play position the
+    patch reports.
+
+    The patch side works in "stream frames", a running frame counter that only goes
+    forward. It reads the buffer at (frame % buffer length), and reports the counter
+    every block, either in a parameter or through an outport named by positionTag. The
+    processor reads the parameter on the audio thread. Outport messages arrive later,
+    on the message thread, and not at all when rendering offline, so they're the
+    fallback. When loop is set, the file repeats seamlessly. When it isn't, frames past
+    the end of the file are silence. A jump in the reported position is treated as a
+    seek. The ring refills from there, and the frames it hasn't reached yet count as
+    underruns.
+
+    Only the first moment of audio is read when the stream is created, so startup
+    time and memory don't depend on the length of the file.
+*/
+class StreamingDataref : private juce::TimeSliceClient
+{
+public:
+    // Returns null and fills error if the file can't be opened
+    static std::unique_ptr<StreamingDataref> open(const juce::File& file, double ringSeconds, bool loop,
+                                                  juce::String& error);
+    ~StreamingDataref() override;
+
+    // The buffer to hand to RNBO, valid for the lifetime of this object
+    char* getRingData() const               { return reinterpret_cast<char*>(_ring.get()); }
+    size_t getRingSizeInBytes() const       { return (size_t) _ringFrames * (size_t) _numChannels * sizeof(float); }
+    int getNumChannels() const              { return _numChannels; }
+    double getSampleRate() const            { return _sampleRate; }
+
+    // Any thread, normally the audio thread after each block
+    void setPlayPosition(juce::int64 streamFrame) noexcept;
+
+    // Times the patch reached frames the prefetch thread hadn't filled yet
+    int getNumUnderruns() const noexcept    { return _underruns.load(std::memory_order_relaxed); }
+
+private:
+    // one prefetch thread shared by every stream in the process
+    struct PrefetchThread : public juce::TimeSliceThread
+    {
+        PrefetchThread() : juce::TimeSliceThread("RNBO dataref prefetch")  { startThread(); }
+        ~PrefetchThread() override                                          { stopThread(2000); }
+    };
+
+    static constexpr int chunkFrames = 8192;    // frames read per time slice
+
+    StreamingDataref() = default;
+
+    int useTimeSlice() override;
+    int fillAhead(int maxFrames);
+    void readFrames(juce::int64 streamFrame, int numFrames);
+
+    juce::SharedResourcePointer<PrefetchThread> _thread;
+    std::unique_ptr<juce::AudioFormatReader>    _reader;
+    juce::AudioBuffer<float>                    _readBuffer;    // prefetch thread scratch
+    juce::HeapBlock<float>                      _ring;
+    int                                         _ringFrames = 0;
+    int                                         _guardFrames = 0;   // kept behind the play position, never overwritten
+    int                                         _numChannels = 0;
+    double                                      _sampleRate = 0.0;
+    juce::int64                                 _fileFrames = 0;
+    bool                                        _loop = true;
+
+    // stream frames [_filledStart, _filledEnd) are in the ring
+    std::atomic<juce::int64>                    _playFrame { 0 };
+    std::atomic<juce::int64>                    _filledStart { 0 };
+    std::atomic<juce::int64>                    _filledEnd { 0 };
+    std::atomic<int>                            _underruns { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingDataref)
+};
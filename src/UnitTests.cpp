@@ -0,0 +1,655 @@
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include "AudioTap.h"
+#include "BlockClock.h"
+#include "LockFreeQueue.h"
+#include "OutportEventBus.h"
+#include "ParameterSmoother.h"
+#include "ParameterValueSlots.h"
+#include "PresetFile.h"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+// Unit tests for the lock-free handoffs and the formats the processor and the interface share.
+// Run by `ctest`, or directly with an optional --category; exits with 1 if any test failed.
+
+class LockFreeQueueTests : public juce::UnitTest
+{
+public:
+    LockFreeQueueTests() : juce::UnitTest("LockFreeQueue", "RNBO") {}
+
+    void runTest() override
+    {
+        beginTest("Items come out in order and a full queue drops the push");
+        {
+            LockFreeQueue<int, 8> queue;
+            int value = 0;
+            expect(! queue.pop(value));
+
+            // the fifo keeps one slot free to tell full from empty
+            int numPushed = 0;
+            while (queue.push(numPushed))
+                numPushed++;
+
+            expectEquals(numPushed, 7);
+            expectEquals(queue.getNumReady(), 7);
+
+            for (int i = 0; i < numPushed; i++) {
+                expect(queue.pop(value));
+                expectEquals(value, i);
+            }
+
+            expect(! queue.pop(value));
+        }
+
+        beginTest("Wraps around the end of its storage");
+        {
+            LockFreeQueue<int, 4> queue;
+            int value = 0;
+
+            for (int i = 0; i < 20; i++) {
+                expect(queue.push(i));
+                expect(queue.push(i + 100));
+                expect(queue.pop(value));
+                expectEquals(value, i);
+                expect(queue.pop(value));
+                expectEquals(value, i + 100);
+            }
+        }
+
+        beginTest("One producer and one consumer thread see every item once, in order");
+        {
+            LockFreeQueue<int, 64> queue;
+            constexpr int numItems = 200000;
+
+            std::thread producer([&queue] {
+                for (int i = 0; i < numItems;) {
+                    if (queue.push(i))
+                        i++;
+                    else
+                        std::this_thread::yield();
+                }
+            });
+
+            int expected = 0;
+            bool inOrder = true;
+            while (expected < numItems) {
+                int value = 0;
+                if (queue.pop(value)) {
+                    inOrder = inOrder && value == expected;
+                    expected++;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+
+            producer.join();
+            expect(inOrder);
+            expectEquals(queue.getNumReady(), 0);
+        }
+    }
+};
+
+static LockFreeQueueTests lockFreeQueueTests;
+
+//==============================================================================
+class ParameterValueSlotsTests : public juce::UnitTest
+{
+public:
+    ParameterValueSlotsTests() : juce::UnitTest("ParameterValueSlots", "RNBO") {}
+
+    void runTest() override
+    {
+        beginTest("Writes coalesce into the latest value per slot");
+        {
+            ParameterValueSlots slots;
+            slots.resize(4);
+            expect(! slots.hasPendingValues());
+
+            expect(slots.set(1, 0.25f));
+            expect(! slots.set(1, 0.5f));
+            expect(! slots.set(3, 1.0f));
+            expect(slots.hasPendingValues());
+
+            std::vector<std::pair<int, float>> drained;
+            slots.drain([&drained](int index, float value) { drained.push_back({ index, value }); });
+
+            expectEquals((int) drained.size(), 2);
+            expectEquals(drained[0].first, 1);
+            expectEquals(drained[0].second, 0.5f);
+            expectEquals(drained[1].first, 3);
+            expectEquals(drained[1].second, 1.0f);
+            expect(! slots.hasPendingValues());
+
+            int numCalls = 0;
+            slots.drain([&numCalls](int, float) { numCalls++; });
+            expectEquals(numCalls, 0);
+
+            // the next batch wakes the reader again
+            expect(slots.set(0, 0.75f));
+        }
+
+        beginTest("Writes outside the slots are ignored");
+        {
+            ParameterValueSlots slots;
+            slots.resize(2);
+            expect(! slots.set(-1, 1.0f));
+            expect(! slots.set(2, 1.0f));
+            expect(! slots.hasPendingValues());
+        }
+
+        beginTest("A reader on another thread never goes back and ends with the last value written");
+        {
+            ParameterValueSlots slots;
+            slots.resize(8);
+            constexpr int numWrites = 100000;
+            std::atomic<bool> done { false };
+
+            std::thread writer([&slots, &done] {
+                for (int i = 1; i <= numWrites; i++) {
+                    slots.set(i % 8, (float) i);
+                }
+                done.store(true);
+            });
+
+            // a value written just before a drain can be delivered again by the next one
+            std::vector<float> latest(8, 0.0f);
+            bool increasing = true;
+            auto collect = [&latest, &increasing](int index, float value) {
+                increasing = increasing && value >= latest[(size_t) index];
+                latest[(size_t) index] = value;
+            };
+
+            while (! done.load())
+                slots.drain(collect);
+
+            writer.join();
+            slots.drain(collect);
+
+            expect(increasing);
+            for (int i = 0; i < 8; i++) {
+                const int last = numWrites - ((numWrites - i) % 8);
+                expectEquals(latest[(size_t) i], (float) last);
+            }
+        }
+    }
+};
+
+static ParameterValueSlotsTests parameterValueSlotsTests;
+
+//==============================================================================
+class BlockClockTests : public juce::UnitTest
+{
+public:
+    BlockClockTests() : juce::UnitTest("BlockClock", "RNBO") {}
+
+    void runTest() override
+    {
+        // 10 ms blocks
+        constexpr int blockSize = 480;
+        constexpr double sampleRate = 48000.0;
+
+        beginTest("Arrivals during the previous block keep their distance from its start");
+        {
+            BlockClock clock;
+            clock.beginBlock(blockSize, sampleRate);
+            const double blockStart = clock.getSampleTimeMs(0);
+            bool late = true;
+
+            expectWithinAbsoluteError(clock.getSampleOffset(blockStart - 5.0, late), blockSize / 2, 1);
+            expect(! late);
+            expectWithinAbsoluteError(clock.getSampleOffset(blockStart - 9.0, late), 48, 1);
+            expect(! late);
+            expectWithinAbsoluteError(clock.getSampleTimeMs(48), blockStart + 1.0, 1.0e-6);
+        }
+
+        beginTest("Late and early arrivals are clamped to the block");
+        {
+            BlockClock clock;
+            clock.beginBlock(blockSize, sampleRate);
+            const double blockStart = clock.getSampleTimeMs(0);
+            bool late = false;
+
+            expectEquals(clock.getSampleOffset(blockStart - 25.0, late), 0);
+            expect(late);
+            expectEquals(clock.getSampleOffset(blockStart + 100.0, late), blockSize - 1);
+            expect(! late);
+        }
+
+        beginTest("The prediction starts again after a stall");
+        {
+            BlockClock clock;
+            clock.beginBlock(blockSize, sampleRate);
+            expectEquals(clock.getSampleTimeMs(0), clock.getMeasuredSampleTimeMs(0));
+
+            juce::Thread::sleep(100);
+            clock.beginBlock(blockSize, sampleRate);
+            expectEquals(clock.getSampleTimeMs(0), clock.getMeasuredSampleTimeMs(0));
+            expectEquals(clock.getSampleRate(), sampleRate);
+        }
+    }
+};
+
+static BlockClockTests blockClockTests;
+
+//==============================================================================
+class PresetFileTests : public juce::UnitTest
+{
+public:
+    PresetFileTests() : juce::UnitTest("PresetFile", "RNBO") {}
+
+    void runTest() override
+    {
+        const std::vector<PresetFile::Parameter> parameters {
+            { "kink1", 0.25 },
+            { "drone_pitch", -12.5 },
+            { juce::String(juce::CharPointer_UTF8("d\xc3\xa9tune")), 1.0e-9 },
+            { "gain", 1.0 }
+        };
+
+        for (const bool compress : { false, true }) {
+            beginTest(compress ? "Compressed presets decode to what was encoded"
+                               : "Uncompressed presets decode to what was encoded");
+
+            const juce::MemoryBlock data = PresetFile::encode(parameters, compress);
+            expect(PresetFile::hasPresetHeader(data));
+
+            std::vector<PresetFile::Parameter> decoded;
+            juce::String error;
+            expect(PresetFile::decode(data, decoded, error), error);
+            expectEquals((int) decoded.size(), (int) parameters.size());
+
+            for (size_t i = 0; i < juce::jmin(decoded.size(), parameters.size()); i++) {
+                expectEquals(decoded[i].id, parameters[i].id);
+                expectEquals(decoded[i].value, parameters[i].value);
+            }
+        }
+
+        beginTest("Anything else is rejected with a reason");
+        {
+            std::vector<PresetFile::Parameter> decoded;
+            juce::String error;
+
+            const juce::MemoryBlock legacy("<?xml version", 13);
+            expect(! PresetFile::hasPresetHeader(legacy));
+            expect(! PresetFile::decode(legacy, decoded, error));
+            expect(error.isNotEmpty());
+
+            // a newer format than this build knows
+            juce::MemoryBlock newer = PresetFile::encode(parameters, false);
+            static_cast<char*>(newer.getData())[4] = (char) (PresetFile::currentVersion + 1);
+            error = {};
+            expect(! PresetFile::decode(newer, decoded, error));
+            expect(error.contains("newer"));
+
+            // cut off in the middle of the entries
+            const juce::MemoryBlock full = PresetFile::encode(parameters, false);
+            const juce::MemoryBlock truncated(full.getData(), full.getSize() / 2);
+            error = {};
+            expect(! PresetFile::decode(truncated, decoded, error));
+            expect(error.isNotEmpty());
+        }
+    }
+};
+
+static PresetFileTests presetFileTests;
+
+//==============================================================================
+class ParameterSmootherTests : public juce::UnitTest
+{
+public:
+    ParameterSmootherTests() : juce::UnitTest("ParameterSmoother", "RNBO") {}
+
+    void runTest() override
+    {
+        RNBO::CoreObject coreObject;
+        RNBO::ParameterInfo info;
+        const RNBO::ParameterIndex index = findContinuousParameter(coreObject, info);
+
+        beginTest("Parameters that aren't smoothed are left to the caller");
+        {
+            ParameterSmoother smoother;
+            expect(! smoother.setTarget(coreObject, 0, 0.0));
+
+            smoother.setSettings({}, coreObject);
+            smoother.process(coreObject, blockSize, sampleRate);
+            expect(! smoother.setTarget(coreObject, 0, 0.0));
+        }
+
+        if (index < 0) {
+            logMessage("The export has no continuous parameter, skipping the ramp tests");
+            return;
+        }
+
+        const double range = info.max - info.min;
+        const double mid = info.min + 0.5 * range;
+        coreObject.prepareToProcess(sampleRate, blockSize);
+
+        beginTest("A linear ramp covers the change in the set time");
+        {
+            setDirectly(coreObject, index, info.min);
+
+            ParameterSmoother smoother;
+            smoother.setSettings({ { index, rampMilliseconds, ParameterSmoother::Curve::linear } }, coreObject);
+            processBlock(coreObject, smoother);
+
+            expect(smoother.setTarget(coreObject, index, info.max));
+            processBlock(coreObject, smoother);
+            const double afterOneBlock = coreObject.getParameterValue(index);
+            expectGreaterThan(afterOneBlock, info.min);
+            expectLessThan(afterOneBlock, mid);
+
+            // 480 samples: 4 more blocks is 320, still on the way
+            processBlocks(coreObject, smoother, 4);
+            expectLessThan(coreObject.getParameterValue(index), info.max - 1.0e-3 * range);
+
+            processBlocks(coreObject, smoother, 4);
+            expectWithinAbsoluteError(coreObject.getParameterValue(index), info.max, 1.0e-4 * range);
+
+            beginTest("A ramp starts from a value that was set directly while idle");
+            setDirectly(coreObject, index, mid);
+            expect(smoother.setTarget(coreObject, index, info.min));
+            processBlock(coreObject, smoother);
+            const double fromDirect = coreObject.getParameterValue(index);
+            expectLessThan(fromDirect, mid);
+            expectGreaterThan(fromDirect, mid - 0.25 * range);
+
+            processBlocks(coreObject, smoother, 8);
+            expectWithinAbsoluteError(coreObject.getParameterValue(index), info.min, 1.0e-4 * range);
+
+            beginTest("An automated value that already reached the object while idle isn't undone");
+            setDirectly(coreObject, index, mid);
+            expect(smoother.setTarget(coreObject, index, mid, true));
+            processBlock(coreObject, smoother);
+            expectWithinAbsoluteError(coreObject.getParameterValue(index), mid, 1.0e-4 * range);
+        }
+
+        beginTest("An exponential ramp gets 99% of the way in the set time");
+        {
+            setDirectly(coreObject, index, info.min);
+
+            ParameterSmoother smoother;
+            smoother.setSettings({ { index, rampMilliseconds, ParameterSmoother::Curve::exponential } }, coreObject);
+            processBlock(coreObject, smoother);
+
+            expect(smoother.setTarget(coreObject, index, info.max));
+            processBlock(coreObject, smoother);
+            expectLessThan(coreObject.getParameterValue(index), info.max - 0.1 * range);
+
+            // 512 samples, one step past the set time
+            processBlocks(coreObject, smoother, 7);
+            const double remaining = info.max - coreObject.getParameterValue(index);
+            expectGreaterOrEqual(remaining, 0.0);
+            expectLessThan(remaining, 0.01 * range);
+        }
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 64;
+    static constexpr double rampMilliseconds = 10.0;
+
+    static RNBO::ParameterIndex findContinuousParameter(RNBO::CoreObject& coreObject, RNBO::ParameterInfo& info)
+    {
+        for (RNBO::ParameterIndex i = 0; i < (RNBO::ParameterIndex) coreObject.getNumParameters(); i++) {
+            coreObject.getParameterInfo(i, &info);
+            if (info.visible && info.type == RNBO::ParameterTypeNumber && info.steps == 0 && info.max > info.min)
+                return i;
+        }
+
+        return -1;
+    }
+
+    void processBlock(RNBO::CoreObject& coreObject, ParameterSmoother& smoother)
+    {
+        const int numInputs = (int) coreObject.getNumInputChannels();
+        const int numOutputs = (int) coreObject.getNumOutputChannels();
+        samples.assign((size_t) ((numInputs + numOutputs) * blockSize), 0.0);
+        channels.clear();
+        for (int channel = 0; channel < numInputs + numOutputs; channel++) {
+            channels.push_back(samples.data() + channel * blockSize);
+        }
+
+        smoother.process(coreObject, blockSize, sampleRate);
+        coreObject.process(channels.data(), (RNBO::Index) numInputs,
+                           channels.data() + numInputs, (RNBO::Index) numOutputs, (RNBO::Index) blockSize);
+    }
+
+    void processBlocks(RNBO::CoreObject& coreObject, ParameterSmoother& smoother, int numBlocks)
+    {
+        for (int i = 0; i < numBlocks; i++) {
+            processBlock(coreObject, smoother);
+        }
+    }
+
+    // the way the morph and restored state set it, without the smoother
+    void setDirectly(RNBO::CoreObject& coreObject, RNBO::ParameterIndex index, double value)
+    {
+        ParameterSmoother idle;
+        coreObject.setParameterValue(index, value, coreObject.getCurrentTime());
+        processBlock(coreObject, idle);
+    }
+
+    std::vector<RNBO::SampleValue> samples;
+    std::vector<RNBO::SampleValue*> channels;
+};
+
+static ParameterSmootherTests parameterSmootherTests;
+
+//==============================================================================
+class AudioTapTests : public juce::UnitTest
+{
+public:
+    AudioTapTests() : juce::UnitTest("AudioTap", "RNBO") {}
+
+    void runTest() override
+    {
+        beginTest("Nothing is recorded without a reader");
+        {
+            AudioTap tap;
+            juce::AudioBuffer<float> buffer(2, 256);
+            buffer.clear();
+            tap.push(buffer, 256, 48000.0);
+
+            expectEquals((int) tap.getNumWritten(), 0);
+            float dest[16];
+            expect(! tap.readLatest(dest, 16));
+        }
+
+        beginTest("readLatest returns the newest samples, mixed to mono, across the end of the ring");
+        {
+            AudioTap tap;
+            tap.addReader();
+
+            constexpr int blockSize = 1000;
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            float dest[AudioTap::maxReadSamples];
+
+            int numPushed = 0;
+            while (numPushed < AudioTap::capacity + 5 * blockSize) {
+                // the left channel counts up, the right is one ahead, so mono is the count plus a half
+                for (int i = 0; i < blockSize; i++) {
+                    buffer.setSample(0, i, (float) (numPushed + i));
+                    buffer.setSample(1, i, (float) (numPushed + i + 1));
+                }
+
+                tap.push(buffer, blockSize, 48000.0);
+                numPushed += blockSize;
+
+                if (numPushed < AudioTap::maxReadSamples)
+                    expect(! tap.readLatest(dest, AudioTap::maxReadSamples));
+            }
+
+            expectEquals((int) tap.getNumWritten(), numPushed);
+            expectEquals(tap.getSampleRate(), 48000.0);
+            expect(tap.readLatest(dest, AudioTap::maxReadSamples));
+
+            bool matches = true;
+            for (int i = 0; i < AudioTap::maxReadSamples; i++) {
+                const int sample = numPushed - AudioTap::maxReadSamples + i;
+                matches = matches && dest[i] == (float) sample + 0.5f;
+            }
+
+            expect(matches);
+            tap.removeReader();
+        }
+    }
+};
+
+static AudioTapTests audioTapTests;
+
+//==============================================================================
+class OutportEventBusTests : public juce::UnitTest
+{
+public:
+    OutportEventBusTests() : juce::UnitTest("OutportEventBus", "RNBO") {}
+
+    void runTest() override
+    {
+        const RNBO::MessageTag levelTag = RNBO::TAG("level");
+        const RNBO::MessageTag stepsTag = RNBO::TAG("steps");
+
+        beginTest("Subscribers see the newest message per tag and how many arrived");
+        {
+            OutportEventBus bus;
+            bus.setTags({ "level", "steps", "trigger" });
+
+            std::vector<OutportEventBus::Event> levels;
+            expect(bus.subscribe("level", [&levels](const OutportEventBus::Event& e) { levels.push_back(e); }) >= 0);
+            expectEquals(bus.subscribe("missing", [](const OutportEventBus::Event&) {}), -1);
+
+            expect(! bus.hasPendingEvents());
+            for (int i = 1; i <= 5; i++) {
+                expect(bus.post(RNBO::MessageEvent(levelTag, 0.0, 0.1 * i), "level"));
+            }
+            expect(bus.hasPendingEvents());
+
+            bus.drain();
+            expect(! bus.hasPendingEvents());
+            expectEquals((int) levels.size(), 1);
+            expect(levels[0].type == OutportEventBus::Event::Number);
+            expectEquals(levels[0].getNumber(), 0.5);
+            expectEquals((int) levels[0].numCoalesced, 5);
+
+            // nothing new, nobody is called
+            bus.drain();
+            expectEquals((int) levels.size(), 1);
+        }
+
+        beginTest("Lists are kept up to maxListValues, bangs have no values");
+        {
+            OutportEventBus bus;
+            bus.setTags({ "level", "steps" });
+
+            OutportEventBus::Event steps;
+            bus.subscribe("steps", [&steps](const OutportEventBus::Event& e) { steps = e; });
+
+            RNBO::UniqueListPtr list(new RNBO::list());
+            for (int i = 0; i < OutportEventBus::maxListValues + 4; i++) {
+                list->push((RNBO::number) i);
+            }
+
+            expect(bus.post(RNBO::MessageEvent(stepsTag, 0.0, std::move(list)), "steps"));
+            bus.drain();
+            expect(steps.type == OutportEventBus::Event::List);
+            expectEquals(steps.numValues, OutportEventBus::maxListValues);
+            expectEquals(steps.values[(size_t) OutportEventBus::maxListValues - 1], (double) OutportEventBus::maxListValues - 1);
+
+            expect(bus.post(RNBO::MessageEvent(stepsTag, 0.0), "steps"));
+            bus.drain();
+            expect(steps.type == OutportEventBus::Event::Bang);
+            expectEquals(steps.numValues, 0);
+        }
+
+        beginTest("Unknown tags are dropped and unsubscribed callbacks aren't called");
+        {
+            OutportEventBus bus;
+            bus.setTags({ "level" });
+
+            int numCalls = 0;
+            const int id = bus.subscribe("level", [&numCalls](const OutportEventBus::Event&) { numCalls++; });
+
+            expect(! bus.post(RNBO::MessageEvent(RNBO::TAG("other"), 0.0, 1.0), "other"));
+            expect(! bus.hasPendingEvents());
+
+            // once a tag has been seen it's matched without the name
+            expect(bus.post(RNBO::MessageEvent(levelTag, 0.0, 1.0), "level"));
+            expect(bus.post(RNBO::MessageEvent(levelTag, 0.0, 2.0), nullptr));
+            bus.drain();
+            expectEquals(numCalls, 1);
+
+            bus.unsubscribe(id);
+            bus.post(RNBO::MessageEvent(levelTag, 0.0, 3.0), "level");
+            bus.drain();
+            expectEquals(numCalls, 1);
+        }
+
+        beginTest("A drain on another thread never sees a torn list");
+        {
+            OutportEventBus bus;
+            bus.setTags({ "steps" });
+
+            bool consistent = true;
+            int numSeen = 0;
+            bus.subscribe("steps", [&consistent, &numSeen](const OutportEventBus::Event& e) {
+                // every list the producer posts holds one value repeated
+                for (int i = 1; i < e.numValues; i++) {
+                    consistent = consistent && e.values[(size_t) i] == e.values[0];
+                }
+                numSeen++;
+            });
+
+            std::atomic<bool> done { false };
+            std::thread producer([&bus, &done, stepsTag] {
+                for (int n = 0; n < 20000; n++) {
+                    RNBO::UniqueListPtr list(new RNBO::list());
+                    for (int i = 0; i < OutportEventBus::maxListValues; i++) {
+                        list->push((RNBO::number) n);
+                    }
+                    bus.post(RNBO::MessageEvent(stepsTag, 0.0, std::move(list)), "steps");
+                }
+                done.store(true);
+            });
+
+            while (! done.load())
+                bus.drain();
+
+            producer.join();
+            bus.drain();
+
+            expect(consistent);
+            expectGreaterThan(numSeen, 0);
+        }
+    }
+};
+
+static OutportEventBusTests outportEventBusTests;
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (args.containsOption("--category"))
+        runner.runTestsInCategory(args.getValueForOption("--category"));
+    else
+        runner.runAllTests();
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); i++) {
+        numFailures += runner.getResult(i)->failures;
+    }
+
+    std::cout << (numFailures == 0 ? "All tests passed" : juce::String(numFailures) + " failures") << std::endl;
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include "AnimationClock.h"
+#include <algorithm>
+
+//==============================================================================
+AnimationClock::AnimationClock()
+{
+    lastFrameMs = juce::Time::getMillisecondCounterHiRes();
+}
+
+AnimationClock::~AnimationClock()
+{
+    stopTimer();
+}
+
+void AnimationClock::subscribe(Listener* listener, juce::Component* component)
+{
+    jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+
+    if (listener == nullptr || isSubscribed(listener))
+        return;
+
+    // coming back from idle, don't report the idle time as one huge frame
+    if (subscribers.empty())
+        lastFrameMs = juce::Time::getMillisecondCounterHiRes();
+
+    subscribers.push_back({ listener, component });
+    updateFrameSource();
+}
+
+void AnimationClock::unsubscribe(Listener* listener)
+{
+    jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+
+    subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                     [listener](const Subscriber& s) { return s.listener == listener; }),
+                      subscribers.end());
+    updateFrameSource();
+}
+
+bool AnimationClock::isSubscribed(Listener* listener) const
+{
+    return std::any_of(subscribers.begin(), subscribers.end(),
+                       [listener](const Subscriber& s) { return s.listener == listener; });
+}
+
+void AnimationClock::setMaxFrameRate(int framesPerSecond)
+{
+    maxFrameRate = juce::jlimit(1, 240, framesPerSecond);
+
+    if (isTimerRunning())
+        startTimerHz(maxFrameRate);
+}
+
+void AnimationClock::timerCallback()
+{
+#if JUCE_MAJOR_VERSION >= 7
+    if (vblank != nullptr)
+    {
+        if (! isVBlankStalled(juce::Time::getMillisecondCounterHiRes()))
+            return;
+
+        // the source window is hidden or minimised, move to one that is showing
+        if (vblankComponent == nullptr || ! vblankComponent->isShowing())
+            updateFrameSource();
+    }
+#endif
+
+    tick();
+}
+
+#if JUCE_MAJOR_VERSION >= 7
+void AnimationClock::vblankCallback()
+{
+    lastVBlankMs = juce::Time::getMillisecondCounterHiRes();
+    tick();
+}
+
+bool AnimationClock::isVBlankStalled(double nowMs) const
+{
+    return nowMs - lastVBlankMs > 2.0 * 1000.0 / maxFrameRate;
+}
+#endif
+
+void AnimationClock::tick()
+{
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+
+    // vblank can run faster than we want to animate, skip until a frame interval has passed
+    // (with a little slack so a 60 Hz display reliably gives 30 frames per second)
+    const double frameIntervalMs = 1000.0 / maxFrameRate;
+    if (nowMs - lastFrameMs < frameIntervalMs * 0.8)
+        return;
+
+    const double deltaSeconds = (nowMs - lastFrameMs) * 0.001;
+    lastFrameMs = nowMs;
+    elapsedSeconds += deltaSeconds;
+
+    frameSubscribers = subscribers;
+
+    for (auto& subscriber : frameSubscribers)
+    {
+        // an earlier callback in this frame may have unsubscribed it
+        if (! isSubscribed(subscriber.listener))
+            continue;
+
+        if (subscriber.component != nullptr && ! subscriber.component->isShowing())
+        {
+            unsubscribe(subscriber.listener);
+            continue;
+        }
+
+        subscriber.listener->animationFrame(elapsedSeconds, deltaSeconds);
+    }
+}
+
+void AnimationClock::updateFrameSource()
+{
+    if (subscribers.empty())
+    {
+        stopTimer();
+#if JUCE_MAJOR_VERSION >= 7
+        vblank.reset();
+        vblankComponent = nullptr;
+#endif
+        return;
+    }
+
+#if JUCE_MAJOR_VERSION >= 7
+    auto isVBlankSource = [this](const Subscriber& s) { return s.component == vblankComponent; };
+
+    const bool sourceGone = std::none_of(subscribers.begin(), subscribers.end(), isVBlankSource)
+                         || (vblankComponent != nullptr && ! vblankComponent->isShowing());
+
+    if (vblank == nullptr || sourceGone)
+    {
+        vblank.reset();
+        vblankComponent = nullptr;
+
+        // any showing subscriber will do, all editors get called from the same vblank
+        for (auto& subscriber : subscribers)
+        {
+            if (subscriber.component != nullptr && subscriber.component->isShowing())
+            {
+                vblankComponent = subscriber.component;
+                vblank = std::make_unique<juce::VBlankAttachment>(vblankComponent, [this] { vblankCallback(); });
+                lastVBlankMs = juce::Time::getMillisecondCounterHiRes();
+                break;
+            }
+        }
+    }
+#endif
+
+    // with a vblank source this is only the fallback, timerCallback() skips while vblanks arrive
+    if (! isTimerRunning())
+        startTimerHz(maxFrameRate);
+}
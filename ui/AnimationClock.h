@@ -0,0 +1,75 @@
+#ifndef RNBO_JUCE_EXAMPLE_ANIMATIONCLOCK_H
+#define RNBO_JUCE_EXAMPLE_ANIMATIONCLOCK_H
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+// One animation clock for every open editor in the process. Hold it through a
+// juce::SharedResourcePointer<AnimationClock> so all editors share the same instance.
+//
+// Frames are driven by the display's vertical blank where JUCE supports it (JUCE 7+),
+// and by a timer otherwise, capped at a maximum frame rate. The vblank comes from one
+// showing subscriber's window; the timer keeps running beside it and takes over if that
+// window stops delivering vblanks (e.g. it was minimised), so other editors keep
+// moving. Time advances from real elapsed time, and every subscriber is called in the
+// same pass, so all editors move in phase and their repaints land in the same frame. A
+// subscriber whose component is no longer showing is unsubscribed automatically.
+// Message thread only.
+class AnimationClock : private juce::Timer
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // seconds is the clock's running time, deltaSeconds the time since the previous frame
+        virtual void animationFrame(double seconds, double deltaSeconds) = 0;
+    };
+
+    AnimationClock();
+    ~AnimationClock() override;
+
+    // component is the one being animated, it's used for the vblank source and to detect hiding
+    void subscribe(Listener* listener, juce::Component* component);
+    void unsubscribe(Listener* listener);
+    bool isSubscribed(Listener* listener) const;
+
+    void setMaxFrameRate(int framesPerSecond);
+    int getMaxFrameRate() const { return maxFrameRate; }
+    double getTimeSeconds() const { return elapsedSeconds; }
+
+private:
+    struct Subscriber
+    {
+        Listener* listener;
+        juce::Component* component;
+    };
+
+    void timerCallback() override;
+    void tick();
+    void updateFrameSource();
+
+    std::vector<Subscriber> subscribers;
+    std::vector<Subscriber> frameSubscribers; // copy iterated during a frame, callbacks may unsubscribe
+
+    int maxFrameRate = 30;
+    double lastFrameMs = 0.0;
+    double elapsedSeconds = 0.0;
+
+#if JUCE_MAJOR_VERSION >= 7
+    void vblankCallback();
+    bool isVBlankStalled(double nowMs) const;
+
+    std::unique_ptr<juce::VBlankAttachment> vblank;
+    juce::Component* vblankComponent = nullptr;
+    double lastVBlankMs = 0.0;
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnimationClock)
+};
+
+#endif //RNBO_JUCE_EXAMPLE_ANIMATIONCLOCK_H
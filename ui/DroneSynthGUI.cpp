@@ -3,9 +3,32 @@
 //
 #include "DroneSynthGUI.h"
 #include <cmath>
+#include <limits>
 
 //==============================================================================
 DroneSynthGUI::DroneSynthGUI()
+{
+    parameterIndexBySlider.fill(-1);
+    valueLabelValues.fill(std::numeric_limits<int>::min());
+
+    setSize(700, 360);  // Slightly wider to accommodate spread sliders
+
+    // Labels and sliders are created the first time we go on screen, see createControls().
+    // Hosts construct editors they never show, and scanning or loading a session shouldn't
+    // pay for components nobody sees.
+}
+
+DroneSynthGUI::~DroneSynthGUI()
+{
+    loadMeterPoller.stopTimer();
+    idlePoller.stopTimer();
+    analyser.reset();
+    unsubscribeFromOutports();
+    cancelPendingUpdate();
+    animationClock->unsubscribe(this);
+}
+
+void DroneSynthGUI::createControls()
 {
     // Setup title
     titleLabel.setText("ARRAS", juce::dontSendNotification);
@@ -58,88 +81,100 @@ DroneSynthGUI::DroneSynthGUI()
     configureSlider(slider5.get(), "SUS", 0.0, 100.0, 100.0);   // Sustain level
     configureSlider(slider6.get(), "REL", 0.0, 500.0, 50.0);    // Release time
 
-    startTimerHz(30);
-    setSize(700, 360);  // Slightly wider to accommodate spread sliders
-}
+    auto sliders = getSliders();
+    for (int i = 0; i < 6; ++i)
+        lastPaintedValues[(size_t) i] = sliders[i]->getValue();
 
-DroneSynthGUI::~DroneSynthGUI()
-{
-    stopTimer();
+    if (processor != nullptr)
+        bindParameters();
+
+    resized();
 }
 
 //==============================================================================
 void DroneSynthGUI::paint(juce::Graphics& g)
 {
-    drawBackground(g);
+    frameProfiler.beginFrame();
 
-    auto bounds = getLocalBounds();
-    auto sliderArea = bounds.reduced(40, 70).withTrimmedBottom(40);
+    {
+        FrameProfiler::ScopedSection paintSection(frameProfiler, FrameProfiler::Paint);
+        paintFrame(g);
+    }
 
-    // Slimmer sliders - reduced width, more spacing
-    int sliderWidth = 28;  // Slimmer
-    int spacing = 25;      // More spacing between sliders
-    int totalWidth = sliderWidth * 6 + spacing * 5;
-    int startX = bounds.getCentreX() - totalWidth / 2;
+    frameProfiler.endFrame();
+
+    // drawn outside the timed sections so it doesn't measure itself
+    if (frameProfiler.isOverlayVisible() && g.getClipBounds().intersects(FrameProfiler::getOverlayBounds()))
+        frameProfiler.drawOverlay(g, FrameProfiler::getOverlayBounds());
+}
+
+void DroneSynthGUI::paintFrame(juce::Graphics& g)
+{
+    {
+        FrameProfiler::ScopedSection backgroundSection(frameProfiler, FrameProfiler::Background);
+
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        if (backgroundLayer.isNull() || scale != cachedLayerScale)
+            renderCachedLayers(scale);
+
+        // static artwork is a single blit, only the fills, particles and values are drawn per frame
+        g.drawImage(backgroundLayer, getLocalBounds().toFloat());
+    }
+
+    // only columns inside the dirty region need their fills and particles drawn
+    auto clip = g.getClipBounds();
 
     // Array of slider colors for neon effect
     std::array<juce::Colour, 6> sliderColors = {
         neonCyan, neonMagenta, neonGreen, neonOrange, neonPink, neonPurple
     };
 
-    std::array<juce::String, 6> sliderLabels = {
-        "METRO", "MOD", "ATT", "DEC", "SUS", "REL"
-    };
+    auto sliders = getSliders();
 
-    std::array<juce::Slider*, 6> sliders = {slider1.get(), slider2.get(), slider3.get(),
-                                            slider4.get(), slider5.get(), slider6.get()};
+    // the time dependent particle terms are shared by all columns
+    if (isPoweredOn)
+        particles.advanceTo(time);
 
     for (int i = 0; i < 6; ++i)
     {
-        auto sliderBounds = juce::Rectangle<int>(
-            startX + i * (sliderWidth + spacing),
-            sliderArea.getY(),
-            sliderWidth,
-            sliderArea.getHeight()
-        );
+        if (sliders[i] == nullptr || ! clip.intersects(getColumnRepaintArea(i)))
+            continue;
 
-        drawSliderBackground(g, sliderBounds, i);
+        float fillLevel = getFillLevel(*sliders[i]);
 
-        if (sliders[i] != nullptr)
-        {
-            float fillLevel = (float)((sliders[i]->getValue() - sliders[i]->getMinimum()) /
-                                      (sliders[i]->getMaximum() - sliders[i]->getMinimum()));
-
-            // Draw neon liquid fill
-            drawSliderFill(g, sliders[i], sliderColors[i]);
+        // Draw neon liquid fill
+        drawSliderFill(g, sliders[i], sliderColors[i]);
 
-            // Add particle effects
-            drawParticleEffects(g, sliderBounds, fillLevel, sliderColors[i]);
+        // Add particle effects
+        drawParticleEffects(g, getSliderColumnBounds(i), fillLevel, sliderColors[i]);
+    }
 
-            // Draw slider label
-            g.setColour(juce::Colours::white.withAlpha(0.7f));
-            g.setFont(juce::Font(10.0f, juce::Font::bold));
-            g.drawText(sliderLabels[i],
-                      sliderBounds.withTrimmedBottom(-25).translated(0, -15),
-                      juce::Justification::centred, false);
+    // slider names sit on top of the liquid
+    g.drawImage(labelLayer, getLocalBounds().toFloat());
 
-            // Draw value label
-            if (fillLevel > 0.01f)
-            {
-                int value = (int)sliders[i]->getValue();
-                g.setColour(sliderColors[i].withAlpha(0.9f));
-                g.setFont(juce::Font(9.0f));
-                g.drawText(juce::String(value),
-                          sliderBounds.withTrimmedTop(sliderBounds.getHeight() - 20),
-                          juce::Justification::centred, false);
-            }
-        }
+    for (int i = 0; i < 6; ++i)
+    {
+        if (sliders[i] != nullptr && getFillLevel(*sliders[i]) > 0.01f && clip.intersects(getColumnRepaintArea(i)))
+            drawValueLabel(g, i, sliderColors[i]);
     }
 
-    drawPowerButton(g);
+    if (clip.intersects(getPowerButtonRepaintArea()))
+        drawPowerButton(g);
+
+    if (clip.intersects(getLoadMeterBounds()))
+        drawLoadMeter(g);
+
+    if (clip.intersects(getScopeBounds()) || clip.intersects(getSpectrumBounds()))
+        drawAnalyser(g);
 }
 
 void DroneSynthGUI::resized()
 {
+    // cached layers and value label layouts depend on the size
+    backgroundLayer = {};
+    labelLayer = {};
+    valueLabelValues.fill(std::numeric_limits<int>::min());
+
     auto bounds = getLocalBounds();
 
     // Title at the top
@@ -172,43 +207,162 @@ void DroneSynthGUI::resized()
 
 void DroneSynthGUI::mouseDown(const juce::MouseEvent& event)
 {
-    auto bounds = getLocalBounds();
-
-    int buttonSize = 28;  // Smaller
-    int buttonX = bounds.getCentreX() - buttonSize / 2;
-    int buttonY = bounds.getBottom() - 50;
-
-    juce::Rectangle<int> buttonBounds(buttonX, buttonY, buttonSize, buttonSize);
+    if (event.mods.isPopupMenu())
+    {
+        showProfilerMenu();
+        return;
+    }
 
-    if (buttonBounds.contains(event.getPosition()))
+    if (getPowerButtonBounds().contains(event.getPosition()))
     {
         isPoweredOn = !isPoweredOn;
         powerButtonAnim = 1.0f;
 
-        repaint();
+        // particles appear or disappear in every column
+        repaint(getPowerButtonRepaintArea());
+        for (int i = 0; i < 6; ++i)
+            repaint(getColumnRepaintArea(i));
+
+        updateAnimationState();
     }
 }
 
 //==============================================================================
-void DroneSynthGUI::timerCallback()
+void DroneSynthGUI::animationFrame(double, double deltaSeconds)
 {
-    time += 0.02f;
+    // the animation was tuned at 0.02 time units and 0.05 power fade per 1/30 s frame,
+    // keep those speeds in real time; cap the step so a stalled message thread doesn't jump
+    const float delta = (float) juce::jmin(deltaSeconds, 0.1);
+
+    time += 0.6f * delta;
 
     if (powerButtonAnim > 0.0f)
     {
-        powerButtonAnim -= 0.05f;
+        powerButtonAnim -= 1.5f * delta;
         powerButtonAnim = juce::jmax(0.0f, powerButtonAnim);
+        repaint(getPowerButtonRepaintArea());
+    }
+
+    flushHostNotifications();
+
+    parameterFeedback.drain([this](int index, float value) {
+        updateSliderForParam((unsigned long) index, value);
+    });
+
+    // subscribers see the latest message per outport, however many arrived since the last frame
+    if (processor != nullptr)
+        processor->getOutportEvents().drain();
+
+    // repaint only the columns whose value moved or whose particles are alive
+    auto sliders = getSliders();
+    for (int i = 0; i < 6; ++i)
+    {
+        const double value = sliders[i]->getValue();
+        if (value != lastPaintedValues[(size_t) i] || areParticlesAnimating(i))
+        {
+            lastPaintedValues[(size_t) i] = value;
+            repaint(getColumnRepaintArea(i));
+        }
     }
 
-    repaint();
+    if (frameProfiler.isOverlayVisible())
+        repaint(FrameProfiler::getOverlayBounds());
+
+    updateAnalyserPaths();
+
+    updateAnimationState();
+}
+
+void DroneSynthGUI::handleAsyncUpdate()
+{
+    updateAnimationState();
+}
+
+void DroneSynthGUI::updateAnimationState()
+{
+    const bool showing = isShowing();
+
+    if (showing && ! hasControls())
+        createControls();
+
+    // the readout and the analyser are only worth running while someone can see them,
+    // and the audio thread stops recording for the analyser once it goes
+    if (showing && processor != nullptr)
+    {
+        if (! loadMeterPoller.isTimerRunning())
+        {
+            updateLoadMeterText();
+            loadMeterPoller.startTimerHz(4);
+        }
+
+        // a new frame wakes the animation if it went idle on a settled picture
+        if (analyser == nullptr)
+            analyser = std::make_unique<SignalAnalyser>(processor->getAudioTap(), [this] { triggerAsyncUpdate(); });
+    }
+    else
+    {
+        loadMeterPoller.stopTimer();
+        analyser.reset();
+        analyserFrame = {};     // the next analyser counts its frames from 1 again
+    }
+
+    if (showing && isAnimating())
+        animationClock->subscribe(this, this);
+    else
+        animationClock->unsubscribe(this);
+
+    if (showing && processor != nullptr && ! animationClock->isSubscribed(this))
+    {
+        if (! idlePoller.isTimerRunning())
+            idlePoller.startTimerHz(animationClock->getMaxFrameRate());
+    }
+    else
+    {
+        idlePoller.stopTimer();
+    }
+}
+
+void DroneSynthGUI::checkPendingEvents()
+{
+    if (processor == nullptr)
+        return;
+
+    if (parameterFeedback.hasPendingValues() || processor->getOutportEvents().hasPendingEvents())
+        updateAnimationState();
+}
+
+bool DroneSynthGUI::isAnimating() const
+{
+    // the analyser only publishes frames while the picture changes
+    if (powerButtonAnim > 0.0f || parameterFeedback.hasPendingValues() || frameProfiler.isOverlayVisible()
+        || (analyser != nullptr && analyser->hasFrameAfter(analyserFrame.number))
+        || (processor != nullptr && processor->getOutportEvents().hasPendingEvents()))
+        return true;
+
+    if (! hasControls())
+        return false;
+
+    auto sliders = getSliders();
+    for (int i = 0; i < 6; ++i)
+    {
+        if (hostNotificationPending[(size_t) i]
+            || sliders[i]->getValue() != lastPaintedValues[(size_t) i]
+            || areParticlesAnimating(i))
+            return true;
+    }
+
+    return false;
+}
+
+bool DroneSynthGUI::areParticlesAnimating(int sliderIndex) const
+{
+    return isPoweredOn && getFillLevel(*getSliders()[(size_t) sliderIndex]) > 0.01f;
 }
 
 void DroneSynthGUI::sliderValueChanged(juce::Slider* slider)  // Changed from 'sliderThatWasMoved' to 'slider'
 {
     //[UsersliderValueChanged_Pre]
     if (processor == nullptr) return;
-    RNBO::CoreObject& coreObject = processor->getRnboObject();
-    auto parameters = processor->getParameters();
     //[/UsersliderValueChanged_Pre]
 
     if (slider == slider1.get())  // Changed from 'sliderThatWasMoved' to 'slider'
@@ -243,22 +397,240 @@ void DroneSynthGUI::sliderValueChanged(juce::Slider* slider)  // Changed from 's
     }
 
     //[UsersliderValueChanged_Post]
-    RNBO::ParameterIndex index = coreObject.getParameterIndexForID(slider->getName().toRawUTF8());  // Changed from 'sliderThatWasMoved' to 'slider'
-    if (index != -1) {
-        const auto param = processor->getParameters()[index];
-        auto newVal = slider->getValue();  // Changed from 'sliderThatWasMoved' to 'slider'
+    // Drag events only do a table lookup and a queue push, the audio thread picks the value up
+    // at the start of its next block. The host is told about the change on the next animation frame.
+    // With no audio running nothing would drain the queue, so the change is set directly.
+    const int sliderIndex = getSliderIndex(slider);
+    const RNBO::ParameterIndex index = sliderIndex != -1 ? parameterIndexBySlider[(size_t) sliderIndex] : -1;
+    if (index != -1 && ! processor->isProcessingAudio()) {
+        if (auto param = getParameterForSlider(sliderIndex)) {
+            const bool needsGesture = ! dragInProgress[(size_t) sliderIndex] && ! shortGestureOpen[(size_t) sliderIndex];
+            if (needsGesture)
+                param->beginChangeGesture();
+
+            param->setValueNotifyingHost((float) processor->getRnboObject().convertToNormalizedParameterValue(index, slider->getValue()));
+
+            if (needsGesture)
+                param->endChangeGesture();
+        }
+    }
+    else if (index != -1 && processor->enqueueParameterChange(index, slider->getValue())) {
+        hostNotificationPending[(size_t) sliderIndex] = true;
+
+        // keyboard and mouse wheel changes have no drag, they get a gesture that ends with the
+        // next host notification
+        if (! dragInProgress[(size_t) sliderIndex] && ! shortGestureOpen[(size_t) sliderIndex]) {
+            if (auto param = getParameterForSlider(sliderIndex)) {
+                param->beginChangeGesture();
+                shortGestureOpen[(size_t) sliderIndex] = true;
+            }
+        }
+    }
+
+    updateAnimationState();
+    //[/UsersliderValueChanged_Post]
+}
 
-        if (param && param->getValue() != newVal)
+void DroneSynthGUI::sliderDragStarted(juce::Slider* slider)
+{
+    const int sliderIndex = getSliderIndex(slider);
+
+    // a wheel gesture still open becomes part of the drag's
+    flushHostNotifications();
+
+    if (sliderIndex != -1)
+        dragInProgress[(size_t) sliderIndex] = true;
+
+    if (auto param = getParameterForSlider(sliderIndex))
+        param->beginChangeGesture();
+}
+
+void DroneSynthGUI::sliderDragEnded(juce::Slider* slider)
+{
+    const int sliderIndex = getSliderIndex(slider);
+
+    flushHostNotifications();
+
+    if (sliderIndex != -1)
+        dragInProgress[(size_t) sliderIndex] = false;
+
+    if (auto param = getParameterForSlider(sliderIndex))
+        param->endChangeGesture();
+}
+
+int DroneSynthGUI::getSliderIndex(juce::Slider* slider) const
+{
+    auto sliders = getSliders();
+
+    for (int i = 0; i < 6; ++i)
+        if (sliders[i] == slider)
+            return i;
+
+    return -1;
+}
+
+juce::AudioProcessorParameter* DroneSynthGUI::getParameterForSlider(int sliderIndex) const
+{
+    if (processor == nullptr || sliderIndex == -1 || parameterIndexBySlider[(size_t) sliderIndex] == -1)
+        return nullptr;
+
+    return processor->getParameters()[parameterIndexBySlider[(size_t) sliderIndex]];
+}
+
+// Tell the host about slider moves that went through the audio thread queue. This runs at most
+// once per frame, however many drag events arrived in between.
+void DroneSynthGUI::flushHostNotifications()
+{
+    if (processor == nullptr) return;
+    RNBO::CoreObject& coreObject = processor->getRnboObject();
+
+    auto sliders = getSliders();
+
+    for (int i = 0; i < 6; ++i)
+    {
+        if (! hostNotificationPending[(size_t) i])
+            continue;
+
+        hostNotificationPending[(size_t) i] = false;
+
+        if (auto param = getParameterForSlider(i))
         {
-            auto normalizedValue = coreObject.convertToNormalizedParameterValue(index, newVal);
-            param->beginChangeGesture();
-            param->setValueNotifyingHost(normalizedValue);
-            param->endChangeGesture();
+            auto index = parameterIndexBySlider[(size_t) i];
+            param->sendValueChangedMessageToListeners((float) coreObject.convertToNormalizedParameterValue(index, sliders[i]->getValue()));
+
+            if (shortGestureOpen[(size_t) i])
+            {
+                shortGestureOpen[(size_t) i] = false;
+                param->endChangeGesture();
+            }
         }
     }
-    //[/UsersliderValueChanged_Post]
 }
 
+void DroneSynthGUI::showProfilerMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem("Record Frame Timings", true, frameProfiler.isEnabled(), [this] {
+        frameProfiler.setEnabled(! frameProfiler.isEnabled());
+        repaint(FrameProfiler::getOverlayBounds());
+        updateAnimationState();
+    });
+    menu.addItem("Show Frame Profiler", true, frameProfiler.isOverlayVisible(), [this] {
+        frameProfiler.setExpectedFrameInterval(1.0 / animationClock->getMaxFrameRate());
+        frameProfiler.setOverlayVisible(! frameProfiler.isOverlayVisible());
+        repaint(FrameProfiler::getOverlayBounds());
+        updateAnimationState();
+    });
+    menu.addSeparator();
+    menu.addItem("Save Frame Metrics...", frameProfiler.getNumFrames() > 0, false, [this] { saveFrameMetrics(); });
+    menu.addItem("Reset Frame Metrics", frameProfiler.getNumFrames() > 0, false, [this] { frameProfiler.reset(); });
+
+    // quality against CPU, chosen per instance
+    if (processor != nullptr)
+    {
+        juce::PopupMenu oversampling;
+        for (int factor : { 1, 2, 4, 8 })
+        {
+            oversampling.addItem(juce::String(factor) + "x", true, processor->getOversamplingFactor() == factor,
+                                 [this, factor] { if (processor != nullptr) processor->setOversamplingFactor(factor); });
+        }
+
+        menu.addSeparator();
+        menu.addSubMenu("Oversampling", oversampling);
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this));
+}
+
+void DroneSynthGUI::saveFrameMetrics()
+{
+    auto defaultFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                           .getChildFile("frame-metrics-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json");
+
+    metricsFileChooser = std::make_unique<juce::FileChooser>("Save frame metrics", defaultFile, "*.json");
+    metricsFileChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                                        | juce::FileBrowserComponent::warnAboutOverwriting,
+                                    [this](const juce::FileChooser& chooser) {
+        auto file = chooser.getResult();
+        if (file != juce::File() && ! frameProfiler.writeToFile(file))
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Save frame metrics",
+                                                   "Couldn't write " + file.getFullPathName());
+    });
+}
+
+//==============================================================================
+std::array<juce::Slider*, 6> DroneSynthGUI::getSliders() const
+{
+    return { slider1.get(), slider2.get(), slider3.get(),
+             slider4.get(), slider5.get(), slider6.get() };
+}
+
+juce::Rectangle<int> DroneSynthGUI::getSliderColumnBounds(int index) const
+{
+    auto bounds = getLocalBounds();
+    auto sliderArea = bounds.reduced(40, 70).withTrimmedBottom(40);
+
+    // Slimmer sliders - reduced width, more spacing
+    int sliderWidth = 28;  // Slimmer
+    int spacing = 25;      // More spacing between sliders
+    int totalWidth = sliderWidth * 6 + spacing * 5;
+    int startX = bounds.getCentreX() - totalWidth / 2;
+
+    return { startX + index * (sliderWidth + spacing), sliderArea.getY(), sliderWidth, sliderArea.getHeight() };
+}
+
+// Everything a column draws: its background, the liquid fill (which follows the slider
+// component's bounds), the labels, and the particles that can rise above the top of the column.
+juce::Rectangle<int> DroneSynthGUI::getColumnRepaintArea(int index) const
+{
+    auto area = getSliderColumnBounds(index);
+
+    if (auto slider = getSliders()[(size_t) index])
+        area = area.getUnion(slider->getBounds());
+
+    return area.withTop(0).withBottom(area.getBottom() + 12).expanded(4, 0).getIntersection(getLocalBounds());
+}
+
+juce::Rectangle<int> DroneSynthGUI::getPowerButtonBounds() const
+{
+    auto bounds = getLocalBounds();
+
+    int buttonSize = 28;  // Smaller
+    int buttonX = bounds.getCentreX() - buttonSize / 2;
+    int buttonY = bounds.getBottom() - 50;
+
+    return { buttonX, buttonY, buttonSize, buttonSize };
+}
+
+juce::Rectangle<int> DroneSynthGUI::getPowerButtonRepaintArea() const
+{
+    // includes the glow drawn around the button
+    return getPowerButtonBounds().expanded(8);
+}
+
+juce::Rectangle<int> DroneSynthGUI::getLoadMeterBounds() const
+{
+    // bottom right corner, clear of the power button and the column labels
+    return { getWidth() - 228, getHeight() - 24, 220, 16 };
+}
+
+juce::Rectangle<int> DroneSynthGUI::getScopeBounds() const
+{
+    // bottom left corner, left of the first column
+    return { 8, getHeight() - 82, 180, 50 };
+}
+
+juce::Rectangle<int> DroneSynthGUI::getSpectrumBounds() const
+{
+    // bottom right corner, above the load meter
+    return { getWidth() - 188, getHeight() - 82, 180, 50 };
+}
+
+float DroneSynthGUI::getFillLevel(const juce::Slider& slider)
+{
+    return (float)((slider.getValue() - slider.getMinimum()) /
+                   (slider.getMaximum() - slider.getMinimum()));
+}
 
 //==============================================================================
 void DroneSynthGUI::drawBackground(juce::Graphics& g)
@@ -280,15 +652,181 @@ void DroneSynthGUI::drawBackground(juce::Graphics& g)
     }
 }
 
-void DroneSynthGUI::drawPowerButton(juce::Graphics& g)
+void DroneSynthGUI::renderCachedLayers(float scale)
 {
-    auto bounds = getLocalBounds();
+    cachedLayerScale = scale;
 
-    int buttonSize = 28;  // Smaller
-    int buttonX = bounds.getCentreX() - buttonSize / 2;
-    int buttonY = bounds.getBottom() - 50;
+    const int width = juce::jmax(1, juce::roundToInt((float) getWidth() * scale));
+    const int height = juce::jmax(1, juce::roundToInt((float) getHeight() * scale));
+
+    backgroundLayer = juce::Image(juce::Image::RGB, width, height, false);
+    {
+        juce::Graphics layer(backgroundLayer);
+        layer.addTransform(juce::AffineTransform::scale(scale));
+
+        drawBackground(layer);
+        for (int i = 0; i < 6; ++i)
+            drawSliderBackground(layer, getSliderColumnBounds(i), i);
+        drawAnalyserFrames(layer);
+    }
+
+    labelLayer = juce::Image(juce::Image::ARGB, width, height, true);
+    {
+        juce::Graphics layer(labelLayer);
+        layer.addTransform(juce::AffineTransform::scale(scale));
+        drawSliderLabels(layer);
+    }
+}
+
+void DroneSynthGUI::drawSliderLabels(juce::Graphics& g)
+{
+    std::array<juce::String, 6> sliderLabels = {
+        "METRO", "MOD", "ATT", "DEC", "SUS", "REL"
+    };
+
+    g.setColour(juce::Colours::white.withAlpha(0.7f));
+    g.setFont(labelFont);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        g.drawText(sliderLabels[i],
+                  getSliderColumnBounds(i).withTrimmedBottom(-25).translated(0, -15),
+                  juce::Justification::centred, false);
+    }
+}
+
+void DroneSynthGUI::drawValueLabel(juce::Graphics& g, int index, juce::Colour color)
+{
+    auto& glyphs = valueLabelGlyphs[(size_t) index];
+    const int value = (int)getSliders()[(size_t) index]->getValue();
+
+    // same layout Graphics::drawText would produce, but only redone when the number changes
+    if (value != valueLabelValues[(size_t) index])
+    {
+        valueLabelValues[(size_t) index] = value;
+
+        auto sliderBounds = getSliderColumnBounds(index);
+        auto area = sliderBounds.withTrimmedTop(sliderBounds.getHeight() - 20).toFloat();
+
+        glyphs.clear();
+        glyphs.addCurtailedLineOfText(valueFont, juce::String(value), 0.0f, 0.0f, area.getWidth(), false);
+        glyphs.justifyGlyphs(0, glyphs.getNumGlyphs(), area.getX(), area.getY(), area.getWidth(), area.getHeight(),
+                             juce::Justification::centred);
+    }
+
+    g.setColour(color.withAlpha(0.9f));
+    glyphs.draw(g);
+}
+
+void DroneSynthGUI::updateLoadMeterText()
+{
+    if (processor == nullptr || ! isShowing())
+        return;
+
+    auto snapshot = processor->getLoadMeter().getSnapshot();
+
+    juce::String text;
+    if (snapshot.numBlocks > 0)
+        text << "DSP " << juce::roundToInt(snapshot.currentLoad * 100.0) << "%"
+             << "  p99 " << juce::roundToInt(snapshot.getLoadPercentile(0.99) * 100.0) << "%"
+             << "  peak " << juce::roundToInt(snapshot.worstLoad * 100.0) << "%"
+             << "  xruns " << (juce::int64) snapshot.numOverruns;
+
+    if (text != loadMeterText)
+    {
+        loadMeterText = text;
+        loadMeterHadOverruns = snapshot.numOverruns > 0;
+        repaint(getLoadMeterBounds());
+    }
+}
 
-    juce::Rectangle<int> buttonBounds(buttonX, buttonY, buttonSize, buttonSize);
+void DroneSynthGUI::drawLoadMeter(juce::Graphics& g)
+{
+    if (loadMeterText.isEmpty())
+        return;
+
+    // turns red once any block has missed its deadline
+    g.setColour(loadMeterHadOverruns ? neonPink.withAlpha(0.8f) : juce::Colours::white.withAlpha(0.45f));
+    g.setFont(valueFont);
+    g.drawText(loadMeterText, getLoadMeterBounds(), juce::Justification::centredRight, false);
+}
+
+void DroneSynthGUI::updateAnalyserPaths()
+{
+    if (analyser == nullptr || ! analyser->getLatestFrame(analyserFrame))
+        return;
+
+    auto scope = getScopeBounds().toFloat().reduced(2.0f);
+    const float xStep = scope.getWidth() / (float) (SignalAnalyser::numScopePoints - 1);
+
+    scopePath.clear();
+    for (int i = 0; i < SignalAnalyser::numScopePoints; ++i)
+    {
+        const float x = scope.getX() + (float) i * xStep;
+        const float y = scope.getCentreY() - analyserFrame.scope[(size_t) i] * scope.getHeight() * 0.5f;
+
+        if (i == 0)
+            scopePath.startNewSubPath(x, y);
+        else
+            scopePath.lineTo(x, y);
+    }
+
+    auto spectrum = getSpectrumBounds().toFloat().reduced(2.0f);
+    const float bandWidth = spectrum.getWidth() / (float) SignalAnalyser::numSpectrumBands;
+
+    spectrumPath.clear();
+    spectrumPath.startNewSubPath(spectrum.getBottomLeft());
+    for (int i = 0; i < SignalAnalyser::numSpectrumBands; ++i)
+    {
+        const float y = spectrum.getBottom() - analyserFrame.spectrum[(size_t) i] * spectrum.getHeight();
+        spectrumPath.lineTo(spectrum.getX() + ((float) i + 0.5f) * bandWidth, y);
+    }
+    spectrumPath.lineTo(spectrum.getBottomRight());
+    spectrumPath.closeSubPath();
+
+    repaint(getScopeBounds());
+    repaint(getSpectrumBounds());
+}
+
+void DroneSynthGUI::drawAnalyserFrames(juce::Graphics& g)
+{
+    for (auto area : { getScopeBounds(), getSpectrumBounds() })
+    {
+        g.setColour(juce::Colours::white.withAlpha(0.04f));
+        g.fillRoundedRectangle(area.toFloat(), 3.0f);
+        g.setColour(juce::Colours::white.withAlpha(0.1f));
+        g.drawRoundedRectangle(area.toFloat().reduced(0.5f), 3.0f, 1.0f);
+    }
+
+    auto scope = getScopeBounds().toFloat();
+    g.setColour(juce::Colours::white.withAlpha(0.08f));
+    g.drawHorizontalLine(juce::roundToInt(scope.getCentreY()), scope.getX() + 2.0f, scope.getRight() - 2.0f);
+}
+
+void DroneSynthGUI::drawAnalyser(juce::Graphics& g)
+{
+    FrameProfiler::ScopedSection section(frameProfiler, FrameProfiler::Analyser);
+
+    if (analyserFrame.number == 0)
+        return;
+
+    g.setColour(neonCyan.withAlpha(0.8f));
+    g.strokePath(scopePath, juce::PathStrokeType(1.2f));
+
+    auto spectrum = getSpectrumBounds().toFloat();
+    g.setGradientFill(juce::ColourGradient(neonMagenta.withAlpha(0.6f), 0.0f, spectrum.getY(),
+                                           neonPurple.withAlpha(0.15f), 0.0f, spectrum.getBottom(), false));
+    g.fillPath(spectrumPath);
+}
+
+void DroneSynthGUI::drawPowerButton(juce::Graphics& g)
+{
+    FrameProfiler::ScopedSection section(frameProfiler, FrameProfiler::PowerButton);
+
+    auto buttonBounds = getPowerButtonBounds();
+    int buttonSize = buttonBounds.getWidth();
+    int buttonX = buttonBounds.getX();
+    int buttonY = buttonBounds.getY();
 
     float glowIntensity = isPoweredOn ? (0.4f + powerButtonAnim * 0.3f)
                                       : (0.1f + powerButtonAnim * 0.1f);
@@ -349,7 +887,7 @@ void DroneSynthGUI::drawPowerButton(juce::Graphics& g)
     }
 
     g.setColour(juce::Colours::white.withAlpha(isPoweredOn ? 0.9f : 0.5f));
-    g.setFont(juce::Font(14.0f, juce::Font::bold));
+    g.setFont(powerFont);
 
     if (isPoweredOn)
         g.drawText("⏻", buttonBounds.translated(0, -1), juce::Justification::centred);
@@ -389,6 +927,7 @@ void DroneSynthGUI::drawSliderBackground(juce::Graphics& g, juce::Rectangle<int>
 void DroneSynthGUI::drawSliderFill(juce::Graphics& g, juce::Slider* slider, juce::Colour color)
 {
     if (slider == nullptr) return;
+    FrameProfiler::ScopedSection section(frameProfiler, FrameProfiler::SliderFill);
 
     auto bounds = slider->getBounds().toFloat();
     float value = (float)((slider->getValue() - slider->getMinimum()) /
@@ -424,50 +963,35 @@ void DroneSynthGUI::drawSliderFill(juce::Graphics& g, juce::Slider* slider, juce
 
 void DroneSynthGUI::drawParticleEffects(juce::Graphics& g, juce::Rectangle<int> bounds, float fillLevel, juce::Colour color)
 {
+    FrameProfiler::ScopedSection section(frameProfiler, FrameProfiler::Particles);
+
     // Add animated particles based on slider level
     if (fillLevel > 0.01f && isPoweredOn)
-    {
-        int numParticles = (int)(fillLevel * 8);  // More particles
-        for (int i = 0; i < numParticles; ++i)
-        {
-            float x = bounds.getX() + (std::sin(time * 2.0f + i * 0.5f) * 0.3f + 0.5f) * bounds.getWidth();
-            float y = bounds.getBottom() - (fillLevel * bounds.getHeight()) - 5.0f - (i * 4.0f);
+        particles.draw(g, bounds, fillLevel, color);
+}
 
-            // Add some vertical drift
-            y += std::sin(time * 3.0f + i) * 2.0f;
+// [MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void DroneSynthGUI::setAudioProcessor(CustomAudioProcessor *p)
+{
+    // reads the previous processor's tap and listens to its outports
+    analyser.reset();
+    unsubscribeFromOutports();
 
-            float alpha = 0.4f + 0.3f * std::sin(time * 4.0f + i);
-            float size = 1.5f + 1.0f * std::sin(time * 5.0f + i);
+    processor = p;
+    parameterIndexBySlider.fill(-1);
+    slidersByParameterIndex.clear();
 
-            g.setColour(color.withAlpha(alpha));
-            g.fillEllipse(x, y, size, size);
+    // sized now, feedback can arrive as soon as the editor listens to the processor
+    parameterFeedback.resize(processor->getParameters().size());
 
-            // Add a second layer of smaller particles
-            if (fillLevel > 0.5f)
-            {
-                float x2 = bounds.getX() + (std::cos(time + i) * 0.3f + 0.5f) * bounds.getWidth();
-                float y2 = y - 8.0f;
-                g.setColour(color.withAlpha(alpha * 0.5f));
-                g.fillEllipse(x2, y2, size * 0.7f, size * 0.7f);
-            }
-        }
+    if (hasControls())
+        bindParameters();
 
-        // Add occasional "bubble" at the bottom when liquid is high
-        if (fillLevel > 0.7f && std::fmod(time, 0.5f) < 0.1f)
-        {
-            float x = bounds.getX() + bounds.getWidth() * 0.5f;
-            float y = bounds.getBottom() - (fillLevel * bounds.getHeight());
-            g.setColour(color.withAlpha(0.2f));
-            g.fillEllipse(x - 3, y - 3, 6, 6);
-        }
-    }
+    updateAnimationState();
 }
 
-// [MiscUserCode] You can add your own definitions of your custom methods or any other code here...
-void DroneSynthGUI::setAudioProcessor(RNBO::JuceAudioProcessor *p)
+void DroneSynthGUI::bindParameters()
 {
-    processor = p;
-
     RNBO::ParameterInfo parameterInfo;
     RNBO::CoreObject& coreObject = processor->getRnboObject();
 
@@ -492,10 +1016,58 @@ void DroneSynthGUI::setAudioProcessor(RNBO::JuceAudioProcessor *p)
 
         if (slider) {
             slidersByParameterIndex.set(i, slider);
+            parameterIndexBySlider[(size_t) getSliderIndex(slider)] = (RNBO::ParameterIndex) i;
             coreObject.getParameterInfo(i, &parameterInfo);
             slider->setRange(parameterInfo.min, parameterInfo.max);
             slider->setValue(value, juce::dontSendNotification);
         }
     }
 }
+
+bool DroneSynthGUI::subscribeToOutport(const juce::String& tag, OutportEventBus::Callback callback)
+{
+    if (processor == nullptr)
+        return false;
+
+    const int id = processor->getOutportEvents().subscribe(tag, std::move(callback));
+    if (id < 0)
+        return false;
+
+    outportSubscriptions.push_back(id);
+    updateAnimationState();
+    return true;
+}
+
+void DroneSynthGUI::unsubscribeFromOutports()
+{
+    if (processor != nullptr)
+    {
+        for (int id : outportSubscriptions)
+            processor->getOutportEvents().unsubscribe(id);
+    }
+
+    outportSubscriptions.clear();
+}
+
+void DroneSynthGUI::updateSliderForParam(unsigned long index, double value)
+{
+    if (processor == nullptr) return;
+    RNBO::CoreObject& coreObject = processor->getRnboObject();
+    auto slider = slidersByParameterIndex[(int) index];
+    if (slider == nullptr) return;
+
+    // don't fight the user's drag, or our own change the host hasn't been told about yet
+    const int sliderIndex = getSliderIndex(slider);
+    if (slider->getThumbBeingDragged() != -1 || (sliderIndex != -1 && hostNotificationPending[(size_t) sliderIndex]))
+        return;
+
+    auto denormalizedValue = coreObject.convertFromNormalizedParameterValue(index, value);
+    slider->setValue(denormalizedValue, juce::dontSendNotification);
+}
+
+void DroneSynthGUI::parameterChangedFromProcessor(int index, float normalizedValue)
+{
+    // may be the audio thread, so no posting here: the idle poller or the next frame picks it up
+    parameterFeedback.set(index, normalizedValue);
+}
 // [/MiscUserCode]
\ No newline at end of file
@@ -10,10 +10,18 @@
 #include <JuceHeader.h>
 #include "RNBO.h"
 #include "RNBO_JuceAudioProcessor.h"
+#include "CustomAudioProcessor.h"
+#include "ParameterValueSlots.h"
+#include "ParticleField.h"
+#include "AnimationClock.h"
+#include "FrameProfiler.h"
+#include "SignalAnalyser.h"
 #include <array>
+#include <vector>
 
 class DroneSynthGUI : public juce::Component,
-                      private juce::Timer,
+                      private AnimationClock::Listener,
+                      private juce::AsyncUpdater,
                       private juce::Slider::Listener
 {
 public:
@@ -29,32 +37,105 @@ public:
     void mouseDown(const juce::MouseEvent&) override;
 
     //[UserMethods]     -- You can add your own custom methods in this section.
-    void setAudioProcessor(RNBO::JuceAudioProcessor *p);
+    void setAudioProcessor(CustomAudioProcessor *p);
     void updateSliderForParam(unsigned long index, double value);
+
+    // Safe to call from any thread, including the audio thread: it only writes a slot, without
+    // locking or posting. The value is normalized and reaches the slider on the next animation
+    // frame, or within a frame of the idle poller noticing it.
+    void parameterChangedFromProcessor(int index, float normalizedValue);
+
+    // Calls callback on the message thread with the latest message sent to the outport with this tag,
+    // at most once per animation frame. Returns false if the patch has no such outport. Subscriptions
+    // end with this component or when it's given another processor.
+    bool subscribeToOutport(const juce::String& tag, OutportEventBus::Callback callback);
+
+    // Frame-time instrumentation, toggled from the right-click menu
+    FrameProfiler& getFrameProfiler() { return frameProfiler; }
     //[/UserMethods]
 
 private:
     //==============================================================================
-    // Timer callback
-    void timerCallback() override;
+    // Called by the shared animation clock once per frame while we're subscribed
+    void animationFrame(double seconds, double deltaSeconds) override;
+
+    // Wakes the animation after parameter feedback arrived while we were idle
+    void handleAsyncUpdate() override;
 
-    // Slider listener callback
+    // Subscribes to the clock while anything is animating and the editor is showing,
+    // unsubscribes once the GUI is idle or hidden
+    void updateAnimationState();
+    bool isAnimating() const;
+    bool areParticlesAnimating(int sliderIndex) const;
+
+    // Slider listener callbacks
     void sliderValueChanged(juce::Slider* slider) override;
+    void sliderDragStarted(juce::Slider* slider) override;
+    void sliderDragEnded(juce::Slider* slider) override;
+
+    // Builds the labels and sliders, and binds them to the processor if we have one already
+    void createControls();
+    bool hasControls() const { return slider1 != nullptr; }
+    void bindParameters();
+
+    int getSliderIndex(juce::Slider* slider) const;
+    juce::AudioProcessorParameter* getParameterForSlider(int sliderIndex) const;
+    void flushHostNotifications();
+
+    // Right-click menu with the frame profiler options
+    void showProfilerMenu();
+    void saveFrameMetrics();
+
+    // Polls the processor's load meter a few times a second and repaints the readout if it changed
+    void updateLoadMeterText();
+
+    // Rebuilds the scope and spectrum paths when the analyser has a new frame
+    void updateAnalyserPaths();
+
+    void unsubscribeFromOutports();
+    void checkPendingEvents();
+
+    //==============================================================================
+    // Layout helpers, shared by painting, hit testing and dirty-region invalidation
+    std::array<juce::Slider*, 6> getSliders() const;
+    juce::Rectangle<int> getSliderColumnBounds(int index) const;
+    juce::Rectangle<int> getColumnRepaintArea(int index) const;
+    juce::Rectangle<int> getPowerButtonBounds() const;
+    juce::Rectangle<int> getPowerButtonRepaintArea() const;
+    juce::Rectangle<int> getLoadMeterBounds() const;
+    juce::Rectangle<int> getScopeBounds() const;
+    juce::Rectangle<int> getSpectrumBounds() const;
+    static float getFillLevel(const juce::Slider& slider);
 
     //==============================================================================
     // Drawing helpers
+    void paintFrame(juce::Graphics&);
     void drawBackground(juce::Graphics&);
     void drawPowerButton(juce::Graphics&);
     void drawSliderBackground(juce::Graphics&, juce::Rectangle<int>, int index);
     void drawSliderFill(juce::Graphics&, juce::Slider*, juce::Colour);
     void drawParticleEffects(juce::Graphics&, juce::Rectangle<int>, float fillLevel, juce::Colour);
+    void drawSliderLabels(juce::Graphics&);
+    void drawValueLabel(juce::Graphics&, int index, juce::Colour);
+    void drawLoadMeter(juce::Graphics&);
+    void drawAnalyserFrames(juce::Graphics&);
+    void drawAnalyser(juce::Graphics&);
+
+    // Re-renders the static layers at the given physical pixel scale
+    void renderCachedLayers(float scale);
 
     //==============================================================================
     // RNBO wrapper (commented out as in original)
     // juce::ReferenceCountedObjectPtr<rnbo::RNBOWrapper> rnboWrapper;
     //[UserVariables]   -- You can add your own custom variables in this section.
-    RNBO::JuceAudioProcessor *processor = nullptr;
+    CustomAudioProcessor *processor = nullptr;
     HashMap<int, Slider *> slidersByParameterIndex; // used to map parameter index to slider we want to control
+    std::array<RNBO::ParameterIndex, 6> parameterIndexBySlider; // reverse of the above, built once in setAudioProcessor
+    std::array<bool, 6> hostNotificationPending {}; // slider moved since the host was last told about it
+    std::array<bool, 6> dragInProgress {};
+    std::array<bool, 6> shortGestureOpen {}; // gesture begun for a keyboard or wheel change, ended by the next flush
+    ParameterValueSlots parameterFeedback; // latest normalized value per parameter, written by the processor side
+    std::vector<int> outportSubscriptions; // ids in the processor's outport event bus
     //[/UserVariables]
 
     //==============================================================================
@@ -69,11 +150,87 @@ private:
     std::unique_ptr<juce::Slider> slider5;
     std::unique_ptr<juce::Slider> slider6;
 
+    //==============================================================================
+    // Follows the visibility of this component and its parents. Minimising the window doesn't
+    // change visibility, the clock notices that through isShowing() on its next frame.
+    class VisibilityWatcher : public juce::ComponentMovementWatcher
+    {
+    public:
+        explicit VisibilityWatcher(DroneSynthGUI& o) : juce::ComponentMovementWatcher(&o), owner(o) {}
+
+        void componentMovedOrResized(bool, bool) override {}
+        void componentPeerChanged() override        { owner.updateAnimationState(); }
+        void componentVisibilityChanged() override  { owner.updateAnimationState(); }
+
+    private:
+        DroneSynthGUI& owner;
+    };
+
     //==============================================================================
     // Animation / State
+    juce::SharedResourcePointer<AnimationClock> animationClock;
+    VisibilityWatcher visibilityWatcher { *this };
     float time = 0.0f;
+    ParticleField particles;
     float powerButtonAnim = 0.0f;
     bool isPoweredOn = false;
+    std::array<double, 6> lastPaintedValues {}; // slider values the last column repaint was requested for
+
+    //==============================================================================
+    // Profiling
+    FrameProfiler frameProfiler;
+    std::unique_ptr<juce::FileChooser> metricsFileChooser;
+
+    // Independent of the animation clock, the DSP load has to show while the GUI is idle too
+    class LoadMeterPoller : public juce::Timer
+    {
+    public:
+        explicit LoadMeterPoller(DroneSynthGUI& o) : owner(o) {}
+        void timerCallback() override { owner.updateLoadMeterText(); }
+
+    private:
+        DroneSynthGUI& owner;
+    };
+
+    LoadMeterPoller loadMeterPoller { *this };
+
+    // Outport messages and parameter feedback are written on the audio thread, which can't wake
+    // the animation clock. While idle, this checks both at the frame rate and restarts the clock.
+    class IdlePoller : public juce::Timer
+    {
+    public:
+        explicit IdlePoller(DroneSynthGUI& o) : owner(o) {}
+        void timerCallback() override { owner.checkPendingEvents(); }
+
+    private:
+        DroneSynthGUI& owner;
+    };
+
+    IdlePoller idlePoller { *this };
+    juce::String loadMeterText;
+    bool loadMeterHadOverruns = false;
+
+    //==============================================================================
+    // Scope and spectrum. The analyser exists while we're showing with a processor, the
+    // audio side only records while it does.
+    std::unique_ptr<SignalAnalyser> analyser;
+    SignalAnalyser::Frame analyserFrame;
+    juce::Path scopePath;
+    juce::Path spectrumPath;
+
+    //==============================================================================
+    // Cached render layers, invalidated in resized() and when the display scale changes
+    juce::Image backgroundLayer;    // background gradient, grid lines and slider backgrounds
+    juce::Image labelLayer;         // slider names, drawn on top of the liquid fills
+    float cachedLayerScale = 0.0f;
+
+    // value labels are laid out again only when the displayed integer changes
+    std::array<int, 6> valueLabelValues;
+    std::array<juce::GlyphArrangement, 6> valueLabelGlyphs;
+
+    juce::Font labelFont { 10.0f, juce::Font::bold };
+    juce::Font valueFont { 9.0f };
+    juce::Font powerFont { 14.0f, juce::Font::bold };
 
     //==============================================================================
     // Colors - Neon palette
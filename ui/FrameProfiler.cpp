@@ -0,0 +1,244 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+FrameProfiler::FrameProfiler()
+{
+}
+
+void FrameProfiler::setEnabled(bool shouldBeEnabled)
+{
+    if (enabled == shouldBeEnabled)
+        return;
+
+    enabled = shouldBeEnabled;
+    lastFrameStartMs = 0.0;
+
+    if (! enabled)
+        overlayVisible = false;
+}
+
+void FrameProfiler::setOverlayVisible(bool shouldBeVisible)
+{
+    overlayVisible = shouldBeVisible;
+
+    // the overlay shows live numbers, so it needs recording
+    if (overlayVisible)
+        setEnabled(true);
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (! enabled)
+        return;
+
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+
+    // a long gap is the GUI going idle, not a stutter
+    if (lastFrameStartMs > 0.0)
+    {
+        lastFrameIntervalMs = nowMs - lastFrameStartMs;
+
+        if (lastFrameIntervalMs > expectedFrameIntervalMs * 1.5 && lastFrameIntervalMs < 250.0)
+            droppedFrames += juce::jmax((juce::int64) 1, (juce::int64) std::round(lastFrameIntervalMs / expectedFrameIntervalMs) - 1);
+    }
+
+    lastFrameStartMs = nowMs;
+}
+
+void FrameProfiler::endFrame()
+{
+    if (! enabled)
+        return;
+
+    numFrames++;
+
+    for (auto& section : sections)
+        if (section.sampledThisFrame)
+            commitSection(section);
+}
+
+void FrameProfiler::addSample(Section section, juce::int64 ticks)
+{
+    auto& data = sections[(size_t) section];
+    data.frameTicks += ticks;
+    data.sampledThisFrame = true;
+}
+
+void FrameProfiler::commitSection(SectionData& data)
+{
+    const double micros = juce::Time::highResolutionTicksToSeconds(data.frameTicks) * 1.0e6;
+    data.frameTicks = 0;
+    data.sampledThisFrame = false;
+
+    data.windowMicros[(size_t) data.windowPosition] = (float) micros;
+    data.windowPosition = (data.windowPosition + 1) % windowSize;
+    data.windowCount = juce::jmin(data.windowCount + 1, windowSize);
+
+    const int bin = micros < 1.0 ? 0 : juce::jlimit(1, numBins - 1, (int) std::floor(std::log2(micros)) + 1);
+    data.histogram[(size_t) bin]++;
+
+    data.totalSamples++;
+    data.totalMicros += micros;
+    data.maxMicros = juce::jmax(data.maxMicros, micros);
+}
+
+void FrameProfiler::reset()
+{
+    for (auto& section : sections)
+        section = SectionData();
+
+    lastFrameStartMs = 0.0;
+    lastFrameIntervalMs = 0.0;
+    numFrames = 0;
+    droppedFrames = 0;
+}
+
+FrameProfiler::SectionStats FrameProfiler::getStats(Section section) const
+{
+    const auto& data = sections[(size_t) section];
+    SectionStats stats;
+
+    if (data.windowCount == 0)
+        return stats;
+
+    std::array<float, windowSize> sorted;
+    std::copy(data.windowMicros.begin(), data.windowMicros.begin() + data.windowCount, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + data.windowCount);
+
+    auto percentile = [&sorted, &data](double p) {
+        const int index = juce::jlimit(0, data.windowCount - 1, (int) std::ceil(p * data.windowCount) - 1);
+        return sorted[(size_t) index] / 1000.0;
+    };
+
+    double sum = 0.0;
+    for (int i = 0; i < data.windowCount; ++i)
+        sum += sorted[(size_t) i];
+
+    stats.meanMillis = sum / data.windowCount / 1000.0;
+    stats.p50Millis = percentile(0.50);
+    stats.p99Millis = percentile(0.99);
+    stats.maxMillis = sorted[(size_t) data.windowCount - 1] / 1000.0;
+    return stats;
+}
+
+FrameProfiler::Section FrameProfiler::getCostliestHelper() const
+{
+    Section costliest = Background;
+    double highest = -1.0;
+
+    for (int s = Background; s < numSections; ++s)
+    {
+        const double mean = getStats((Section) s).meanMillis;
+        if (mean > highest)
+        {
+            highest = mean;
+            costliest = (Section) s;
+        }
+    }
+
+    return costliest;
+}
+
+const char* FrameProfiler::getSectionName(Section section)
+{
+    switch (section)
+    {
+        case EditorPaint:   return "editorPaint";
+        case Paint:         return "paint";
+        case Background:    return "drawBackground";
+        case SliderFill:    return "drawSliderFill";
+        case Particles:     return "drawParticleEffects";
+        case PowerButton:   return "drawPowerButton";
+        case Analyser:      return "drawAnalyser";
+        case numSections:   break;
+    }
+
+    return "";
+}
+
+void FrameProfiler::drawOverlay(juce::Graphics& g, juce::Rectangle<int> area) const
+{
+    g.setColour(juce::Colours::black.withAlpha(0.75f));
+    g.fillRoundedRectangle(area.toFloat(), 4.0f);
+
+    g.setFont(overlayFont);
+    g.setColour(juce::Colours::white.withAlpha(0.9f));
+
+    auto lines = area.reduced(6, 4);
+    const int lineHeight = 12;
+
+    auto frame = getStats(Paint);
+    g.drawText("paint " + juce::String(frame.meanMillis, 2) + " p99 " + juce::String(frame.p99Millis, 2)
+                   + " max " + juce::String(frame.maxMillis, 2),
+               lines.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+
+    g.drawText(juce::String(lastFrameIntervalMs, 1) + " ms  dropped " + juce::String(droppedFrames)
+                   + "/" + juce::String(numFrames),
+               lines.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+
+    static const char* const shortNames[numSections] = { "editor", "", "background", "fill", "particles", "power", "analyser" };
+    const auto costliest = getCostliestHelper();
+
+    for (int s = EditorPaint; s < numSections; ++s)
+    {
+        if (s == Paint)
+            continue;
+
+        auto stats = getStats((Section) s);
+        g.setColour(s == costliest ? juce::Colours::orange : juce::Colours::white.withAlpha(0.75f));
+        g.drawText(juce::String(shortNames[s]).paddedRight(' ', 11)
+                       + juce::String(stats.meanMillis, 3) + " p99 " + juce::String(stats.p99Millis, 3),
+                   lines.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+    }
+
+    g.setColour(juce::Colours::orange);
+    g.drawText("costliest: " + juce::String(shortNames[costliest]),
+               lines.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+}
+
+juce::var FrameProfiler::toVar() const
+{
+    auto root = new juce::DynamicObject();
+    root->setProperty("frames", numFrames);
+    root->setProperty("dropped_frames", droppedFrames);
+    root->setProperty("expected_frame_interval_ms", expectedFrameIntervalMs);
+    root->setProperty("costliest_helper", getSectionName(getCostliestHelper()));
+
+    juce::Array<juce::var> bins;
+    for (int bin = 0; bin < numBins; ++bin)
+        bins.add(bin == 0 ? 1.0 : std::pow(2.0, (double) bin));
+    root->setProperty("histogram_bin_upper_us", bins);
+
+    auto sectionsObject = new juce::DynamicObject();
+    for (int s = 0; s < numSections; ++s)
+    {
+        const auto& data = sections[(size_t) s];
+        auto stats = getStats((Section) s);
+
+        auto sectionObject = new juce::DynamicObject();
+        sectionObject->setProperty("samples", data.totalSamples);
+        sectionObject->setProperty("session_mean_ms", data.totalSamples > 0 ? data.totalMicros / (double) data.totalSamples / 1000.0 : 0.0);
+        sectionObject->setProperty("session_max_ms", data.maxMicros / 1000.0);
+        sectionObject->setProperty("recent_mean_ms", stats.meanMillis);
+        sectionObject->setProperty("recent_p50_ms", stats.p50Millis);
+        sectionObject->setProperty("recent_p99_ms", stats.p99Millis);
+        sectionObject->setProperty("recent_max_ms", stats.maxMillis);
+
+        juce::Array<juce::var> histogram;
+        for (auto count : data.histogram)
+            histogram.add(count);
+        sectionObject->setProperty("histogram", histogram);
+
+        sectionsObject->setProperty(getSectionName((Section) s), juce::var(sectionObject));
+    }
+    root->setProperty("sections", juce::var(sectionsObject));
+
+    return juce::var(root);
+}
+
+bool FrameProfiler::writeToFile(const juce::File& file) const
+{
+    return file.replaceWithText(juce::JSON::toString(toVar()));
+}
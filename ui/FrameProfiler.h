@@ -0,0 +1,126 @@
+#ifndef RNBO_JUCE_EXAMPLE_FRAMEPROFILER_H
+#define RNBO_JUCE_EXAMPLE_FRAMEPROFILER_H
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+// Optional frame-time instrumentation for the editor. While enabled, every paint and
+// each drawing helper is timed separately. A sample is one frame's total time in a
+// section. The profiler keeps a rolling window of recent frames for percentiles, plus a
+// log2 histogram over the whole session, and counts frames that arrived late against
+// the animation clock. It can draw itself as an overlay and dump everything as JSON.
+// Message thread only. When disabled, a ScopedSection costs one branch.
+class FrameProfiler
+{
+public:
+    enum Section
+    {
+        EditorPaint = 0,    // CustomAudioEditor::paint
+        Paint,              // DroneSynthGUI::paint, including all helpers below
+        Background,         // cached background layers, rebuilt or blitted
+        SliderFill,
+        Particles,
+        PowerButton,
+        Analyser,           // scope and spectrum
+        numSections
+    };
+
+    class ScopedSection
+    {
+    public:
+        ScopedSection(FrameProfiler& p, Section s)
+            : profiler(p.isEnabled() ? &p : nullptr)
+            , section(s)
+            , start(profiler != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~ScopedSection()
+        {
+            if (profiler != nullptr)
+                profiler->addSample(section, juce::Time::getHighResolutionTicks() - start);
+        }
+
+    private:
+        FrameProfiler* profiler;
+        Section section;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedSection)
+    };
+
+    struct SectionStats
+    {
+        double meanMillis = 0.0;
+        double p50Millis = 0.0;
+        double p99Millis = 0.0;
+        double maxMillis = 0.0;
+    };
+
+    FrameProfiler();
+
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const { return enabled; }
+
+    void setOverlayVisible(bool shouldBeVisible);
+    bool isOverlayVisible() const { return overlayVisible; }
+
+    // Frames further apart than 1.5 intervals count as dropped
+    void setExpectedFrameInterval(double seconds) { expectedFrameIntervalMs = seconds * 1000.0; }
+
+    void beginFrame();
+    void endFrame();
+    void addSample(Section section, juce::int64 ticks);
+    void reset();
+
+    SectionStats getStats(Section section) const;
+    Section getCostliestHelper() const;
+    juce::int64 getNumFrames() const     { return numFrames; }
+    juce::int64 getDroppedFrames() const { return droppedFrames; }
+    static const char* getSectionName(Section section);
+
+    void drawOverlay(juce::Graphics&, juce::Rectangle<int> area) const;
+    static juce::Rectangle<int> getOverlayBounds() { return { 8, 8, 186, 118 }; }
+
+    juce::var toVar() const;
+    bool writeToFile(const juce::File& file) const;
+
+private:
+    static constexpr int windowSize = 240;  // about 8 seconds of animation at 30 frames per second
+    static constexpr int numBins = 18;      // log2 bins from below 1 us up to 65 ms and above
+
+    struct SectionData
+    {
+        std::array<float, windowSize> windowMicros {};
+        int windowCount = 0;
+        int windowPosition = 0;
+        std::array<juce::int64, numBins> histogram {};
+        juce::int64 totalSamples = 0;
+        double totalMicros = 0.0;
+        double maxMicros = 0.0;
+        juce::int64 frameTicks = 0;     // accumulated in the current frame
+        bool sampledThisFrame = false;
+    };
+
+    void commitSection(SectionData&);
+
+    bool enabled = false;
+    bool overlayVisible = false;
+
+    std::array<SectionData, numSections> sections;
+
+    double expectedFrameIntervalMs = 1000.0 / 30.0;
+    double lastFrameStartMs = 0.0;
+    double lastFrameIntervalMs = 0.0;
+    juce::int64 numFrames = 0;
+    juce::int64 droppedFrames = 0;
+
+    juce::Font overlayFont { juce::Font::getDefaultMonospacedFontName(), 10.0f, juce::Font::plain };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameProfiler)
+};
+
+#endif //RNBO_JUCE_EXAMPLE_FRAMEPROFILER_H
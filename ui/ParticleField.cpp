@@ -0,0 +1,128 @@
+#include "ParticleField.h"
+#include <cmath>
+
+using FVO = juce::FloatVectorOperations;
+
+//==============================================================================
+ParticleField::ParticleField(int maxParticlesPerColumn)
+{
+    setMaxParticlesPerColumn(maxParticlesPerColumn);
+}
+
+void ParticleField::setMaxParticlesPerColumn(int maxParticlesToUse)
+{
+    maxParticles = juce::jmax(0, maxParticlesToUse);
+    const auto n = (size_t) maxParticles;
+
+    sinHalfPhase.resize(n); cosHalfPhase.resize(n);
+    sinPhase.resize(n);     cosPhase.resize(n);
+    stacking.resize(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        sinHalfPhase[i] = std::sin((float) i * 0.5f);
+        cosHalfPhase[i] = std::cos((float) i * 0.5f);
+        sinPhase[i] = std::sin((float) i);
+        cosPhase[i] = std::cos((float) i);
+        stacking[i] = -4.0f * (float) i;
+    }
+
+    x.resize(n); y.resize(n); alpha.resize(n); size.resize(n); x2.resize(n); y2.resize(n);
+}
+
+void ParticleField::advanceTo(float time)
+{
+    currentTime = time;
+
+    sin1 = std::sin(time);        cos1 = std::cos(time);
+    sin2 = std::sin(time * 2.0f); cos2 = std::cos(time * 2.0f);
+    sin3 = std::sin(time * 3.0f); cos3 = std::cos(time * 3.0f);
+    sin4 = std::sin(time * 4.0f); cos4 = std::cos(time * 4.0f);
+    sin5 = std::sin(time * 5.0f); cos5 = std::cos(time * 5.0f);
+}
+
+void ParticleField::draw(juce::Graphics& g, juce::Rectangle<int> bounds, float fillLevel, juce::Colour color)
+{
+    const int n = juce::jmin(maxParticles, (int)(fillLevel * (float) maxParticles));
+
+    if (n > 0)
+    {
+        const float width = (float) bounds.getWidth();
+        const float centreX = (float) bounds.getX() + 0.5f * width;
+        const float surface = (float) bounds.getBottom() - (fillLevel * (float) bounds.getHeight()) - 5.0f;
+
+        // sin(a*t + b*i) = sin(a*t) * cos(b*i) + cos(a*t) * sin(b*i)
+
+        // x = centre + 0.3 * width * sin(2t + 0.5i)
+        FVO::copyWithMultiply(x.data(), cosHalfPhase.data(), 0.3f * width * sin2, n);
+        FVO::addWithMultiply(x.data(), sinHalfPhase.data(), 0.3f * width * cos2, n);
+        FVO::add(x.data(), centreX, n);
+
+        // y = surface - 4i + 2 * sin(3t + i)
+        FVO::copyWithMultiply(y.data(), cosPhase.data(), 2.0f * sin3, n);
+        FVO::addWithMultiply(y.data(), sinPhase.data(), 2.0f * cos3, n);
+        FVO::add(y.data(), stacking.data(), n);
+        FVO::add(y.data(), surface, n);
+
+        // alpha = 0.4 + 0.3 * sin(4t + i)
+        FVO::copyWithMultiply(alpha.data(), cosPhase.data(), 0.3f * sin4, n);
+        FVO::addWithMultiply(alpha.data(), sinPhase.data(), 0.3f * cos4, n);
+        FVO::add(alpha.data(), 0.4f, n);
+
+        // size = 1.5 + sin(5t + i)
+        FVO::copyWithMultiply(size.data(), cosPhase.data(), sin5, n);
+        FVO::addWithMultiply(size.data(), sinPhase.data(), cos5, n);
+        FVO::add(size.data(), 1.5f, n);
+
+        emit(g, x.data(), y.data(), alpha.data(), size.data(), 1.0f, 1.0f, n, color);
+
+        // Add a second layer of smaller particles
+        if (fillLevel > 0.5f)
+        {
+            // x2 = centre + 0.3 * width * cos(t + i), cos(t + i) = cos(t) * cos(i) - sin(t) * sin(i)
+            FVO::copyWithMultiply(x2.data(), cosPhase.data(), 0.3f * width * cos1, n);
+            FVO::addWithMultiply(x2.data(), sinPhase.data(), -0.3f * width * sin1, n);
+            FVO::add(x2.data(), centreX, n);
+
+            FVO::add(y2.data(), y.data(), -8.0f, n);
+
+            emit(g, x2.data(), y2.data(), alpha.data(), size.data(), 0.7f, 0.5f, n, color);
+        }
+    }
+
+    // Add occasional "bubble" at the bottom when liquid is high
+    if (fillLevel > 0.7f && std::fmod(currentTime, 0.5f) < 0.1f)
+    {
+        float bx = bounds.getX() + bounds.getWidth() * 0.5f;
+        float by = bounds.getBottom() - (fillLevel * bounds.getHeight());
+        g.setColour(color.withAlpha(0.2f));
+        g.fillEllipse(bx - 3, by - 3, 6, 6);
+    }
+}
+
+// Sorts the particles into alpha bands and fills each band with a single path
+void ParticleField::emit(juce::Graphics& g, const float* px, const float* py, const float* palpha, const float* psize,
+                         float sizeScale, float alphaScale, int count, juce::Colour color)
+{
+    for (auto& path : bandPaths)
+        path.clear();
+
+    const float bandWidth = (maxAlpha - minAlpha) / (float) numAlphaBands;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int band = juce::jlimit(0, numAlphaBands - 1, (int)((palpha[i] - minAlpha) / bandWidth));
+        const float d = psize[i] * sizeScale;
+        bandPaths[(size_t) band].addEllipse(px[i], py[i], d, d);
+    }
+
+    for (int band = 0; band < numAlphaBands; ++band)
+    {
+        if (bandPaths[(size_t) band].isEmpty())
+            continue;
+
+        const float bandAlpha = minAlpha + ((float) band + 0.5f) * bandWidth;
+        g.setColour(color.withAlpha(bandAlpha * alphaScale));
+        g.fillPath(bandPaths[(size_t) band]);
+    }
+}
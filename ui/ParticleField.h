@@ -0,0 +1,59 @@
+#ifndef RNBO_JUCE_EXAMPLE_PARTICLEFIELD_H
+#define RNBO_JUCE_EXAMPLE_PARTICLEFIELD_H
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+// Neon particles rising above the liquid fill of a slider column.
+//
+// Particle state is kept as structure-of-arrays. Every particle's motion is a sine
+// of (rate * time + phase), so the per-particle phases are tabulated once and each
+// frame only needs one sin/cos pair per rate; positions, sizes and alphas are then
+// vector multiply-adds over the tables. Particles are emitted as a handful of batched
+// path fills per column, one per alpha band, instead of one fillEllipse each.
+class ParticleField
+{
+public:
+    explicit ParticleField(int maxParticlesPerColumn = 8);
+
+    // Number of particles in a full column, a column at fillLevel shows fillLevel times as many
+    void setMaxParticlesPerColumn(int maxParticles);
+    int getMaxParticlesPerColumn() const { return maxParticles; }
+
+    // Evaluates the time dependent terms, call once per frame before drawing the columns
+    void advanceTo(float time);
+
+    void draw(juce::Graphics&, juce::Rectangle<int> bounds, float fillLevel, juce::Colour);
+
+private:
+    static constexpr int numAlphaBands = 4;
+    static constexpr float minAlpha = 0.1f;
+    static constexpr float maxAlpha = 0.7f;
+
+    void emit(juce::Graphics&, const float* x, const float* y, const float* alpha, const float* size,
+              float sizeScale, float alphaScale, int count, juce::Colour);
+
+    int maxParticles = 0;
+    float currentTime = 0.0f;
+
+    // per-particle phase tables
+    std::vector<float> sinHalfPhase, cosHalfPhase;   // sin/cos(0.5 * i)
+    std::vector<float> sinPhase, cosPhase;           // sin/cos(i)
+    std::vector<float> stacking;                     // -4 * i, particles stack upwards
+
+    // per-frame scratch, reused between columns
+    std::vector<float> x, y, alpha, size, x2, y2;
+
+    // sin/cos of the particle rates for the current frame
+    float sin1 = 0, cos1 = 0, sin2 = 0, cos2 = 0, sin3 = 0, cos3 = 0, sin4 = 0, cos4 = 0, sin5 = 0, cos5 = 0;
+
+    std::array<juce::Path, numAlphaBands> bandPaths;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParticleField)
+};
+
+#endif //RNBO_JUCE_EXAMPLE_PARTICLEFIELD_H